@@ -0,0 +1,45 @@
+#ifndef __ESKF_H__
+#define __ESKF_H__
+
+#include <stdint.h>
+#include "arm_math.h"
+#include "quaternion.h"
+
+/*
+ * error-state kalman filter: attitude quaternion + gyro bias
+ * nominal state: q (body to world), bias (rad/s)
+ * error state: attitude error (rad, body frame), bias error (rad/s), covariance P 6x6
+ * - predict: integrate gyro - bias, propagate P
+ * - accel update: gravity direction, skipped while |accel| is far from 1 g
+ * - zero rate update: while the board is still, gyro - bias = 0, this makes the yaw bias observable
+ * accel in g, gyro in rad/s, same frames as MahonyFilter
+ */
+
+// default tuning for the bmi088 at 1 kHz
+#define ESKF_GYRO_NOISE (1.0e-4f) // rad/s/sqrt(Hz)
+#define ESKF_BIAS_WALK (1.0e-5f)  // rad/s^2/sqrt(Hz)
+#define ESKF_ACCEL_NOISE (0.2f)   // covers the chassis accelerations, not just the sensor noise
+
+// eskf struct
+typedef struct
+{
+    Quaternion q;          // current orientation quaternion
+    float32_t bias[3];     // rad/s, estimated gyro bias
+    float32_t P[6][6];     // error state covariance
+    float32_t gyro_noise;  // rad/s/sqrt(Hz), gyro white noise density
+    float32_t bias_walk;   // rad/s^2/sqrt(Hz), bias random walk density
+    float32_t accel_noise; // normalized accel (gravity direction) noise
+    float32_t sample_freq;
+    uint32_t still_count; // consecutive samples that looked stationary
+} EskfFilter;
+
+void eskf_init(EskfFilter *filter,
+               float32_t gyro_noise, float32_t bias_walk, float32_t accel_noise, float32_t sample_freq);
+
+void eskf_update(EskfFilter *filter, float32_t gyro[3], float32_t accel[3]);
+void eskf_update_dt(EskfFilter *filter, float32_t gyro[3], float32_t accel[3], float32_t dt); // dt in s
+
+Quaternion *eskf_get_quaternion(EskfFilter *filter);
+void eskf_get_euler(EskfFilter *filter, float32_t euler[3]);
+
+#endif // __ESKF_H__
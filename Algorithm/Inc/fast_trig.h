@@ -0,0 +1,26 @@
+#ifndef __FAST_TRIG_H__
+#define __FAST_TRIG_H__
+
+#include "arm_math.h"
+
+/*
+ * single precision trig kernels with a fixed, branch-free instruction count
+ * range reduction plus minimax polynomials, selects instead of branches, no table lookups
+ * all angles in radians
+ *
+ * max error against double precision libm, measured by build_host/trig_bench:
+ *   fast_sin / fast_cos / fast_sin_cos   1.5 ulp on [-pi, pi], 8e-8 absolute for |x| <= 1e4
+ *   fast_atan2                           2.8 ulp
+ *   fast_asin                            2.4 ulp
+ *   fast_acos                            1.3 ulp
+ */
+
+float32_t fast_sin(float32_t x);
+float32_t fast_cos(float32_t x);
+void fast_sin_cos(float32_t x, float32_t *sin_val, float32_t *cos_val);
+
+float32_t fast_atan2(float32_t y, float32_t x); // [-pi, pi]
+float32_t fast_asin(float32_t x);               // [-pi/2, pi/2], x clamped to [-1, 1]
+float32_t fast_acos(float32_t x);               // [0, pi], x clamped to [-1, 1]
+
+#endif // __FAST_TRIG_H__
@@ -0,0 +1,50 @@
+#ifndef __GYRO_CAL_H__
+#define __GYRO_CAL_H__
+
+#include <stdint.h>
+#include "arm_math.h"
+
+/*
+ * stationary gyro bias calibration
+ * samples are gathered into a window while the board looks still (rate close to the current bias,
+ * |accel| close to 1 g), the window mean becomes the bias when its variance says it really was still,
+ * once calibrated a window far from the bias is taken only when GYRO_CAL_RELEARN windows in a row agree on it,
+ * runs all the time: at power up and whenever the robot stands still between rounds
+ * gyro in rad/s (uncorrected), accel in g
+ */
+
+// default tuning for the bmi088 at 1 kHz
+#define GYRO_CAL_WINDOW (2000)      // samples per estimate, 2 s
+#define GYRO_CAL_STILL_SIGMA (0.01f) // rad/s, largest per-axis standard deviation of a still window
+#define GYRO_CAL_RELEARN (3)         // consistent windows in a row that move the bias by more than one step
+
+// gyro calibration struct
+typedef struct
+{
+    float32_t bias[3]; // rad/s, subtracted by gyro_cal_apply
+    uint32_t window;   // samples per estimate
+
+    // running statistics of the current window (welford)
+    uint32_t count;
+    float32_t mean[3];
+    float32_t m2[3];
+
+    // quality of the last accepted window
+    float32_t noise;      // rad/s, largest per-axis standard deviation
+    float32_t bias_sigma; // rad/s, standard error of the bias, noise / sqrt(window)
+    uint32_t accepted;    // windows taken as the bias
+    uint32_t rejected;    // full windows that were too noisy or too far from a plausible bias
+    uint8_t valid;        // 1 once a window has been accepted since init
+
+    // still windows too far from the bias, a real shift repeats, a slow turn does not
+    float32_t jump[3]; // rad/s, mean of the last one
+    uint8_t jumps;     // in a row, each within one step of the one before
+} GyroCal;
+
+void gyro_cal_init(GyroCal *cal, const float32_t bias[3], uint32_t window);
+
+// returns 1 when the sample completed a window that was taken as the new bias
+uint8_t gyro_cal_update(GyroCal *cal, const float32_t gyro[3], const float32_t accel[3]);
+void gyro_cal_apply(const GyroCal *cal, float32_t gyro[3]);
+
+#endif // __GYRO_CAL_H__
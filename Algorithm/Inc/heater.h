@@ -0,0 +1,51 @@
+#ifndef __HEATER_H__
+#define __HEATER_H__
+
+#include <stdint.h>
+#include "pid.h"
+
+/*
+ * imu heater temperature control
+ * full power while far below the setpoint, pi around it, ready once the temperature has stayed in band
+ * the bmi088 refreshes its temperature every 1.28 s in 0.125 degC steps, so there is no d term
+ * temperatures in degC, duty 0 ~ 1, updated every HEATER_PERIOD
+ */
+
+#define HEATER_PERIOD (0.1f)        // s, one heater_update
+#define HEATER_TARGET (45.0f)       // degC, above any venue, leaves duty in hand for cold air
+#define HEATER_WARMUP_BAND (3.0f)   // degC, full power below target - band
+#define HEATER_READY_BAND (0.5f)    // degC, in band long enough sets ready
+#define HEATER_READY_TIME (50)      // updates in band before ready, 5 s
+#define HEATER_LOST_BAND (2.0f)     // degC, out of this band clears ready
+#define HEATER_OVERHEAT (15.0f)     // degC above the target, heater off until heater_init
+#define HEATER_KP (0.25f)           // duty per degC
+#define HEATER_KI (0.001f)          // duty per degC per update
+#define HEATER_I_LIMIT (1.0f)
+
+typedef enum
+{
+    HEATER_WARMUP = 0, // full power
+    HEATER_HOLD,       // pi on the setpoint
+    HEATER_FAULT,      // overheated, off
+} HeaterState;
+
+// heater struct
+typedef struct
+{
+    PidInfo pid;
+    float target; // degC
+    float temp;   // degC, last measurement
+    float duty;   // 0 ~ 1, for the pwm
+
+    HeaterState state;
+    uint32_t in_band;  // consecutive updates within HEATER_READY_BAND
+    uint32_t time;     // updates since heater_init
+    uint32_t ready_at; // time of the last ready, 0 while never ready
+    uint8_t ready;     // temperature settled, gates the gyro bias calibration
+} Heater;
+
+void heater_init(Heater *heater, float target);
+// returns the duty for the pwm
+float heater_update(Heater *heater, float temp);
+
+#endif // __HEATER_H__
@@ -0,0 +1,34 @@
+#ifndef __IMU_CAL_H__
+#define __IMU_CAL_H__
+
+#include <stdint.h>
+#include "arm_math.h"
+
+/*
+ * static imu calibration, fitted on the host by build_host/imu_cal_fit
+ * accel: a = M (a_raw - offset), in g, M may be any matrix, the ellipsoid fit gives a symmetric one:
+ *        scale and cross-axis coupling, not a rotation of the sensor against the board
+ * gyro: w = w_raw - bias(T), bias linearly interpolated in a temperature table, clamped at its ends,
+ *       gyro_cal then only has to learn what the table leaves
+ */
+
+#define IMU_CAL_TEMP_POINTS (8)
+
+// imu calibration struct
+typedef struct
+{
+    float32_t accel_matrix[9]; // row major
+    float32_t accel_offset[3]; // g
+
+    float32_t temp[IMU_CAL_TEMP_POINTS];         // degC, ascending
+    float32_t gyro_bias[IMU_CAL_TEMP_POINTS][3]; // rad/s at temp[i]
+    uint8_t temp_num;                            // table entries used, 0: no temperature compensation
+} ImuCal;
+
+void imu_cal_init(ImuCal *cal); // identity, no table
+
+void imu_cal_accel(const ImuCal *cal, const float32_t raw[3], float32_t accel[3]);
+void imu_cal_gyro(const ImuCal *cal, const float32_t raw[3], float32_t temp, float32_t gyro[3]);
+void imu_cal_gyro_bias(const ImuCal *cal, float32_t temp, float32_t bias[3]);
+
+#endif // __IMU_CAL_H__
@@ -1,6 +1,7 @@
 #ifndef __KINEMATICS_H__
 #define __KINEMATICS_H__
 
+#include <stdint.h>
 #include "arm_math.h"
 
 /*
@@ -11,10 +12,63 @@ chassis frame and layout
    \3    4/
 
     battery
+
+wheels / modules 1 ~ 4: front right, front left, back left, back right, as CHASSIS_FR ~ CHASSIS_BR
+wheel i sits at (+-half_length, +-half_width), wz is counterclockwise seen from above
+chassis velocity (vx, vy, wz) in m/s and rad/s, wheel speeds in rad/s at the wheel, after the mounting sign
+
+omni x:   rollers free, wheel 1 / 3 drive along (1, 1), wheel 2 / 4 along (1, -1)
+mecanum:  wheels drive along x, 45 deg rollers, wheel 1 / 3 rollers pass (1, 1), wheel 2 / 4 pass (1, -1)
+swerve:   each module drives along its steer angle, 0 along +x, counterclockwise
+
+the inverse matrix maps (vx, vy, wz) to the wheel speeds (omni / mecanum) or module velocities (swerve),
+the forward matrix is its least squares pseudo-inverse, both built by kine_init and applied with arm_mat_mult_f32
 */
 
-// omni chassis kinematics decomposition
-void kine_omni_decomposition(float32_t v_chassis[2], float32_t v_wheels[4]);
+#define KINE_WHEEL_NUM (4)
+#define KINE_SWERVE_HOLD (0.02f) // m/s, module speeds below this keep the current steer angle
+
+typedef enum
+{
+    KINE_OMNI_X = 0,
+    KINE_MECANUM,
+    KINE_SWERVE,
+} KineType;
+
+// chassis geometry
+typedef struct
+{
+    KineType type;
+    float wheel_radius;         // m
+    float half_length;          // m, wheel centre to chassis centre along x, wheelbase / 2
+    float half_width;           // m, along y, track / 2
+    float sign[KINE_WHEEL_NUM]; // +1 / -1, wheel speed to motor velocity, mounting direction
+} KineConfig;
+
+// kinematics struct
+typedef struct
+{
+    KineConfig config;
+
+    // omni / mecanum: 4 x 3 and 3 x 4, swerve: 8 x 3 and 3 x 8 on (vx1, vy1, vx2, ...)
+    float32_t inverse_data[2 * KINE_WHEEL_NUM * 3];
+    float32_t forward_data[3 * 2 * KINE_WHEEL_NUM];
+    arm_matrix_instance_f32 inverse;
+    arm_matrix_instance_f32 forward;
+} KineInfo;
+
+void kine_init(KineInfo *kine, const KineConfig *config);
+
+// omni / mecanum: chassis velocity (vx, vy, wz) to wheel speeds, and back from measured wheel speeds
+void kine_inverse(KineInfo *kine, float32_t v_chassis[3], float32_t w_wheels[KINE_WHEEL_NUM]);
+void kine_forward(KineInfo *kine, float32_t w_wheels[KINE_WHEEL_NUM], float32_t v_chassis[3]);
+
+// swerve: steer angles in rad, steer_now the measured angles,
+// a module turns at most 90 deg and reverses its wheel instead, its speed is scaled by the cosine of the steer error
+void kine_swerve_inverse(KineInfo *kine, float32_t v_chassis[3], float32_t steer_now[KINE_WHEEL_NUM],
+                         float32_t w_wheels[KINE_WHEEL_NUM], float32_t steer[KINE_WHEEL_NUM]);
+void kine_swerve_forward(KineInfo *kine, float32_t w_wheels[KINE_WHEEL_NUM], float32_t steer[KINE_WHEEL_NUM],
+                         float32_t v_chassis[3]);
 
 // kinematics for gimbal-follow mode
 void kine_gimbal_follow(float32_t yaw_angle, float32_t v_gimbal_frame[2], float32_t v_chassis_frame[2]);
@@ -5,6 +5,15 @@
 #include "arm_math.h"
 #include "quaternion.h"
 
+// quaternion integrator
+typedef enum
+{
+    MAHONY_INTEGRATOR_EULER = 0, // q += q_dot dt
+    MAHONY_INTEGRATOR_RK2,       // midpoint
+    MAHONY_INTEGRATOR_RK4,       // runge-kutta 4
+    MAHONY_INTEGRATOR_EXP,       // exponential map, exact rotation for a constant rate over dt
+} MahonyIntegrator;
+
 // mahony filter struct
 typedef struct
 {
@@ -14,12 +23,19 @@ typedef struct
     float32_t ki;
     float32_t i_limit;
     float32_t sample_freq;
+    MahonyIntegrator integrator; // defaults to euler
+
+    // accelerometer trust, 0 disables (the default)
+    float32_t accel_band; // g, kp scaled by 1 - ||a| - 1| / accel_band
+    float32_t rate_band;  // rad/s, kp scaled by 1 / (1 + (|w| / rate_band)^2)
+    float32_t kp_effective; // telemetry, kp used by the last update
 } MahonyFilter;
 
 void mahony_init(MahonyFilter *filter,
                  float32_t kp, float32_t ki, float32_t i_limit, float32_t sample_freq);
 
 void mahony_update(MahonyFilter *filter, float32_t gyro[3], float32_t accel[3]);
+void mahony_update_dt(MahonyFilter *filter, float32_t gyro[3], float32_t accel[3], float32_t dt); // dt in s
 
 Quaternion *mahony_get_quaternion(MahonyFilter *filter);
 void mahony_get_euler(MahonyFilter *filter, float32_t euler[3]);
@@ -0,0 +1,55 @@
+#ifndef __PLL_H__
+#define __PLL_H__
+
+#include <stdint.h>
+
+/*
+ * tracking observer for an encoder angle and the reported rpm, a kalman filter with its gains recomputed every frame
+ * states: angle, velocity, acceleration driven by white jerk, and the rounding bias of the rpm
+ * the 13 bit single turn angle and the whole rpm are both measurements with their quantization noise:
+ * - fast motion comes from the rpm without lag
+ * - at creep and steady speed the rounding error is constant, the bias state takes it and the angle sets the velocity
+ * angle in rad, 0 ~ 2pi, wraparound handled inside, velocity in rad/s
+ */
+
+#define PLL_STATES (4)
+#define PLL_RPM_STEP (0.10472f) // rad/s, 1 rpm
+#define PLL_JERK_NOISE (1.0e5f)  // (rad/s^3)^2 s, white jerk density
+#define PLL_BIAS_NOISE (1.0e-4f) // (rad/s)^2 / s, rpm bias wander
+#define PLL_ANGLE_NOISE (7.67e-4f * 7.67e-4f / 12.0f)          // rad^2, 2pi / 8192 quantization
+#define PLL_RPM_NOISE (PLL_RPM_STEP * PLL_RPM_STEP / 12.0f)    // (rad/s)^2, 1 rpm quantization
+#define PLL_ACCEL_INIT (100.0f) // rad/s^2, acceleration uncertainty at lock
+#define PLL_DT_MIN (0.2e-3f)    // s, frame intervals outside this range relock the observer
+#define PLL_DT_MAX (5.0e-3f)    // s
+
+typedef struct
+{
+    // parameters
+    float jerk_noise;  // (rad/s^3)^2 s, higher follows faster motion and trusts the rpm more
+    float bias_noise;  // (rad/s)^2 / s
+    float angle_noise; // rad^2
+    float rpm_noise;   // (rad/s)^2, 0: the rpm is not used
+
+    // estimates
+    float angle;        // rad, 0 ~ 2pi
+    float velocity;     // rad/s
+    float acceleration; // rad/s^2
+    float rpm_bias;     // rad/s, reported minus true velocity
+    float error;        // rad, last angle innovation
+    float p[PLL_STATES][PLL_STATES]; // covariance
+    uint8_t locked;     // 0 until the first measurement
+} PllInfo;
+
+// static initializer, the firmware has no init hook before the first frame
+#define PLL_INIT(jerk_)                                                                                          \
+    {                                                                                                            \
+        .jerk_noise = (jerk_), .bias_noise = PLL_BIAS_NOISE, .angle_noise = PLL_ANGLE_NOISE,                     \
+        .rpm_noise = PLL_RPM_NOISE,                                                                              \
+    }
+
+void pll_init(PllInfo *pll, float jerk_noise);
+// one feedback frame, dt since the previous one, returns the velocity estimate
+float pll_update(PllInfo *pll, float angle, float velocity, float dt);
+void pll_reset(PllInfo *pll); // relock on the next frame
+
+#endif // __PLL_H__
@@ -0,0 +1,66 @@
+#ifndef __POWER_LIMIT_H__
+#define __POWER_LIMIT_H__
+
+#include <stdint.h>
+
+/*
+ * chassis power budget between the wheel pids and the current command
+ * per motor electrical power, m3508 model: p = r i^2 + kt w i + p_static, i commanded, w rotor speed
+ * the current is held until the next allocation while the wheel keeps accelerating, so w is the measured speed
+ * carried one allocation ahead: 2 w - w_last
+ * a braking motor is counted with its copper loss only, regeneration is not credited against the cap
+ * over the limit the currents split into the rotation pattern of the wheels and the rest (translation),
+ * the priority part gets the largest scale that fits, the other part the largest scale on top of it
+ * currents in A, rotor speeds in rad/s, power in W
+ */
+
+#define POWER_WHEEL_NUM (4)
+#define POWER_LIMIT_DEFAULT (60.0f)           // W, chassis power cap
+#define POWER_M3508_RESISTANCE (0.194f)       // ohm, phase resistance
+#define POWER_M3508_KT (0.3f * 187.0f / 3591.0f) // N m / A at the rotor, 0.3 at the output through 3591/187
+#define POWER_M3508_STATIC (0.5f)             // W per motor, esc and rotor losses at zero current
+#define POWER_SEARCH_STEPS (12)               // bisection steps per scale, 1 / 4096 resolution
+
+typedef enum
+{
+    POWER_TRANSLATION_FIRST = 0, // keep the drive direction, spin slows first
+    POWER_ROTATION_FIRST,        // keep the spin, translation slows first
+    POWER_UNIFORM,               // one scale on every current
+} PowerPriority;
+
+// power limit struct
+typedef struct
+{
+    // parameters
+    float limit;          // W
+    float resistance;     // ohm
+    float kt;             // N m / A, rotor
+    float static_power;   // W per motor
+    PowerPriority priority;
+    float rotation[POWER_WHEEL_NUM]; // wheel current pattern of a pure spin, unit length, all 0: uniform
+
+    // state
+    float velocity_last[POWER_WHEEL_NUM]; // rad/s, rotor speeds at the previous allocation
+
+    // last allocation
+    float power_raw;  // W, estimate for the pid currents
+    float power;      // W, estimate for the currents sent
+    float scale[2];   // priority part, other part, 1: untouched
+    uint32_t limited; // allocations that scaled the currents
+} PowerLimit;
+
+// static initializer, the firmware has no init hook before the scheduler
+#define POWER_LIMIT_INIT(limit_)                                                                                 \
+    {                                                                                                            \
+        .limit = (limit_), .resistance = POWER_M3508_RESISTANCE, .kt = POWER_M3508_KT,                         \
+        .static_power = POWER_M3508_STATIC, .priority = POWER_TRANSLATION_FIRST, .scale = {1.0f, 1.0f},         \
+    }
+
+void power_limit_init(PowerLimit *power, float limit);
+void power_limit_set_rotation(PowerLimit *power, const float rotation[POWER_WHEEL_NUM]); // normalized inside
+float power_limit_estimate(const PowerLimit *power, const float current[POWER_WHEEL_NUM],
+                           const float velocity[POWER_WHEEL_NUM]);
+// scales current in place so the estimate stays under the limit, returns the estimate after
+float power_limit_apply(PowerLimit *power, float current[POWER_WHEEL_NUM], const float velocity[POWER_WHEEL_NUM]);
+
+#endif // __POWER_LIMIT_H__
@@ -32,6 +32,12 @@ void quat_inverse(Quaternion *q, Quaternion *result);   // conjugation + norm
 // quaternion derivative operation
 void quat_derivative(Quaternion *q, float32_t w[3], Quaternion *result);
 
+// integrate dq/dt = 0.5 q ⊗ w over dt, w (body frame, rad/s) held constant, q normalized afterwards
+void quat_integrate_euler(Quaternion *q, float32_t w[3], float32_t dt); // first order
+void quat_integrate_rk2(Quaternion *q, float32_t w[3], float32_t dt);   // midpoint, second order
+void quat_integrate_rk4(Quaternion *q, float32_t w[3], float32_t dt);   // fourth order
+void quat_integrate_exp(Quaternion *q, float32_t w[3], float32_t dt);   // exponential map, exact for constant w
+
 // quaterion and vector rotation
 void quat_from_axis_angle(float32_t axis[3], float32_t angle, Quaternion *q);
 void quat_to_axis_angle(Quaternion *q, float32_t axis[3], float32_t *angle);
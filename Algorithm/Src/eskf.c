@@ -0,0 +1,324 @@
+#include "eskf.h"
+#include <string.h>
+#include <math.h>
+
+#define ESKF_EPSILON (1.0e-6f)
+#define ESKF_ATTITUDE_SIGMA0 (0.1f) // rad, initial attitude uncertainty
+#define ESKF_BIAS_SIGMA0 (0.01f)    // rad/s, initial bias uncertainty
+
+#define ESKF_ACCEL_GATE (0.1f)     // g, skip the gravity update when ||a| - 1| is larger
+#define ESKF_STILL_RATE (0.02f)    // rad/s, |gyro - bias| below this counts as still
+#define ESKF_STILL_ACCEL (0.03f)   // g, ||a| - 1| below this counts as still
+#define ESKF_STILL_SAMPLES (500)   // consecutive still samples before zero rate updates
+#define ESKF_RATE_NOISE (0.01f)    // rad/s, zero rate pseudo measurement noise
+
+/*
+ **************************************************************************
+ * 3x3 helpers, the covariance is handled in 3x3 blocks
+ **************************************************************************
+ */
+typedef float32_t Mat3[3][3];
+
+static inline void skew(const float32_t v[3], Mat3 m)
+{
+    m[0][0] = 0.0f;
+    m[0][1] = -v[2];
+    m[0][2] = v[1];
+    m[1][0] = v[2];
+    m[1][1] = 0.0f;
+    m[1][2] = -v[0];
+    m[2][0] = -v[1];
+    m[2][1] = v[0];
+    m[2][2] = 0.0f;
+}
+
+static inline void mat3_mult(Mat3 a, Mat3 b, Mat3 result)
+{
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            result[i][j] = a[i][0] * b[0][j] + a[i][1] * b[1][j] + a[i][2] * b[2][j];
+        }
+    }
+}
+
+static inline void mat3_mult_transpose(Mat3 a, Mat3 b, Mat3 result) // a b^T
+{
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            result[i][j] = a[i][0] * b[j][0] + a[i][1] * b[j][1] + a[i][2] * b[j][2];
+        }
+    }
+}
+
+static inline void get_block(EskfFilter *filter, int row, int col, Mat3 m)
+{
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            m[i][j] = filter->P[row + i][col + j];
+        }
+    }
+}
+
+static inline void set_block(EskfFilter *filter, int row, int col, Mat3 m)
+{
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            filter->P[row + i][col + j] = m[i][j];
+        }
+    }
+}
+
+static inline int mat3_inverse(Mat3 m, Mat3 result)
+{
+    float32_t c00 = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+    float32_t c01 = m[1][2] * m[2][0] - m[1][0] * m[2][2];
+    float32_t c02 = m[1][0] * m[2][1] - m[1][1] * m[2][0];
+    float32_t det = m[0][0] * c00 + m[0][1] * c01 + m[0][2] * c02;
+    if (fabsf(det) < ESKF_EPSILON * ESKF_EPSILON)
+    {
+        return -1;
+    }
+
+    float32_t inv = 1.0f / det;
+    result[0][0] = c00 * inv;
+    result[1][0] = c01 * inv;
+    result[2][0] = c02 * inv;
+    result[0][1] = (m[0][2] * m[2][1] - m[0][1] * m[2][2]) * inv;
+    result[1][1] = (m[0][0] * m[2][2] - m[0][2] * m[2][0]) * inv;
+    result[2][1] = (m[0][1] * m[2][0] - m[0][0] * m[2][1]) * inv;
+    result[0][2] = (m[0][1] * m[1][2] - m[0][2] * m[1][1]) * inv;
+    result[1][2] = (m[0][2] * m[1][0] - m[0][0] * m[1][2]) * inv;
+    result[2][2] = (m[0][0] * m[1][1] - m[0][1] * m[1][0]) * inv;
+    return 0;
+}
+
+/*
+ **************************************************************************
+ * filter steps
+ **************************************************************************
+ */
+static void eskf_predict(EskfFilter *filter, float32_t w[3], float32_t dt)
+{
+    // nominal state: q = q ⊗ exp(w dt / 2), taylor series, |w dt| stays far below 0.1 rad
+    float32_t h[3] = {0.5f * w[0] * dt, 0.5f * w[1] * dt, 0.5f * w[2] * dt};
+    float32_t theta2 = h[0] * h[0] + h[1] * h[1] + h[2] * h[2];
+    float32_t sinc = 1.0f - theta2 * (1.0f / 6.0f) + theta2 * theta2 * (1.0f / 120.0f);
+    Quaternion dq, q;
+    dq.q_w = 1.0f - theta2 * 0.5f + theta2 * theta2 * (1.0f / 24.0f);
+    dq.q_x = h[0] * sinc;
+    dq.q_y = h[1] * sinc;
+    dq.q_z = h[2] * sinc;
+    quat_multiply(&filter->q, &dq, &q);
+    filter->q = q;
+    quat_normalize(&filter->q);
+
+    // error state transition F = [phi, -dt I; 0, I], phi = I - [w dt]x
+    // P = [A, B; B^T, C]:
+    //   A' = phi A phi^T - dt (phi B + B^T phi^T) + dt^2 C + Q_theta
+    //   B' = phi B - dt C
+    //   C' = C + Q_bias
+    Mat3 phi, A, B, C, tmp, phi_a, phi_b;
+    float32_t wdt[3] = {w[0] * dt, w[1] * dt, w[2] * dt};
+    skew(wdt, phi);
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            phi[i][j] = (i == j ? 1.0f : 0.0f) - phi[i][j];
+        }
+    }
+    get_block(filter, 0, 0, A);
+    get_block(filter, 0, 3, B);
+    get_block(filter, 3, 3, C);
+
+    mat3_mult(phi, A, phi_a);
+    mat3_mult_transpose(phi_a, phi, tmp); // phi A phi^T
+    mat3_mult(phi, B, phi_b);
+
+    float32_t q_theta = filter->gyro_noise * filter->gyro_noise * dt;
+    float32_t q_bias = filter->bias_walk * filter->bias_walk * dt;
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            A[i][j] = tmp[i][j] - dt * (phi_b[i][j] + phi_b[j][i]) + dt * dt * C[i][j];
+            B[i][j] = phi_b[i][j] - dt * C[i][j];
+        }
+        A[i][i] += q_theta;
+        C[i][i] += q_bias;
+    }
+
+    set_block(filter, 0, 0, A);
+    set_block(filter, 0, 3, B);
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            filter->P[3 + j][i] = B[i][j];
+        }
+    }
+    set_block(filter, 3, 3, C);
+}
+
+// generic 3 dimension measurement y = H dx + v, H = [H_theta, H_bias], R = r I
+static void eskf_correct(EskfFilter *filter, float32_t y[3], Mat3 H_theta, Mat3 H_bias, float32_t r)
+{
+    // HP = H P (3x6), S = HP H^T + R
+    float32_t HP[3][6];
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 6; j++)
+        {
+            float32_t sum = 0.0f;
+            for (int k = 0; k < 3; k++)
+            {
+                sum += H_theta[i][k] * filter->P[k][j] + H_bias[i][k] * filter->P[3 + k][j];
+            }
+            HP[i][j] = sum;
+        }
+    }
+
+    Mat3 S, S_inv;
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            float32_t sum = 0.0f;
+            for (int k = 0; k < 3; k++)
+            {
+                sum += HP[i][k] * H_theta[j][k] + HP[i][3 + k] * H_bias[j][k];
+            }
+            S[i][j] = sum;
+        }
+        S[i][i] += r;
+    }
+    if (mat3_inverse(S, S_inv) != 0)
+    {
+        return;
+    }
+
+    // K = (HP)^T S^-1 (6x3), dx = K y, P = P - K HP
+    float32_t K[6][3];
+    float32_t dx[6];
+    for (int i = 0; i < 6; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            K[i][j] = HP[0][i] * S_inv[0][j] + HP[1][i] * S_inv[1][j] + HP[2][i] * S_inv[2][j];
+        }
+        dx[i] = K[i][0] * y[0] + K[i][1] * y[1] + K[i][2] * y[2];
+    }
+    for (int i = 0; i < 6; i++)
+    {
+        for (int j = i; j < 6; j++)
+        {
+            float32_t p = filter->P[i][j] - (K[i][0] * HP[0][j] + K[i][1] * HP[1][j] + K[i][2] * HP[2][j]);
+            filter->P[i][j] = p;
+            filter->P[j][i] = p; // keep it symmetric
+        }
+    }
+
+    // inject the error into the nominal state and reset it
+    Quaternion dq = {.q_w = 1.0f, .q_x = 0.5f * dx[0], .q_y = 0.5f * dx[1], .q_z = 0.5f * dx[2]};
+    Quaternion q;
+    quat_multiply(&filter->q, &dq, &q);
+    filter->q = q;
+    quat_normalize(&filter->q);
+    filter->bias[0] += dx[3];
+    filter->bias[1] += dx[4];
+    filter->bias[2] += dx[5];
+}
+
+/*
+ **************************************************************************
+ * exposed interfaces
+ **************************************************************************
+ */
+void eskf_init(EskfFilter *filter,
+               float32_t gyro_noise, float32_t bias_walk, float32_t accel_noise, float32_t sample_freq)
+{
+    quat_identity(&(filter->q));
+    memset(filter->bias, 0, sizeof(filter->bias));
+    memset(filter->P, 0, sizeof(filter->P));
+    for (int i = 0; i < 3; i++)
+    {
+        filter->P[i][i] = ESKF_ATTITUDE_SIGMA0 * ESKF_ATTITUDE_SIGMA0;
+        filter->P[3 + i][3 + i] = ESKF_BIAS_SIGMA0 * ESKF_BIAS_SIGMA0;
+    }
+
+    filter->gyro_noise = gyro_noise;
+    filter->bias_walk = bias_walk;
+    filter->accel_noise = accel_noise;
+    filter->sample_freq = sample_freq;
+    filter->still_count = 0;
+}
+
+void eskf_update(EskfFilter *filter, float32_t gyro[3], float32_t accel[3])
+{
+    eskf_update_dt(filter, gyro, accel, 1.0f / filter->sample_freq);
+}
+
+void eskf_update_dt(EskfFilter *filter, float32_t gyro[3], float32_t accel[3], float32_t dt)
+{
+    float32_t w[3] = {gyro[0] - filter->bias[0], gyro[1] - filter->bias[1], gyro[2] - filter->bias[2]};
+    eskf_predict(filter, w, dt);
+
+    float32_t a_norm = sqrtf(accel[0] * accel[0] + accel[1] * accel[1] + accel[2] * accel[2]);
+    float32_t a_error = fabsf(a_norm - 1.0f);
+    Mat3 H_theta, H_bias;
+
+    // gravity direction: g_b = R^T [0, 0, 1], g_b(true) = g_b + [g_b]x dtheta
+    if (a_error < ESKF_ACCEL_GATE && a_norm > ESKF_EPSILON)
+    {
+        static float32_t world_g[3] = {0.0f, 0.0f, 1.0f};
+        float32_t g_b[3], y[3];
+        Quaternion q_conj;
+        quat_conjugate(&(filter->q), &q_conj);
+        quat_rotate_vector(&q_conj, world_g, g_b);
+
+        float32_t scale = 1.0f / a_norm;
+        for (int i = 0; i < 3; i++)
+        {
+            y[i] = accel[i] * scale - g_b[i];
+        }
+        skew(g_b, H_theta);
+        memset(H_bias, 0, sizeof(H_bias));
+        eskf_correct(filter, y, H_theta, H_bias, filter->accel_noise * filter->accel_noise);
+    }
+
+    // zero rate: a still board measures only the bias, gyro = bias + v
+    float32_t rate2 = w[0] * w[0] + w[1] * w[1] + w[2] * w[2];
+    if (rate2 < ESKF_STILL_RATE * ESKF_STILL_RATE && a_error < ESKF_STILL_ACCEL)
+    {
+        filter->still_count++;
+    }
+    else
+    {
+        filter->still_count = 0;
+    }
+    if (filter->still_count >= ESKF_STILL_SAMPLES)
+    {
+        memset(H_theta, 0, sizeof(H_theta));
+        memset(H_bias, 0, sizeof(H_bias));
+        H_bias[0][0] = H_bias[1][1] = H_bias[2][2] = 1.0f;
+        eskf_correct(filter, w, H_theta, H_bias, ESKF_RATE_NOISE * ESKF_RATE_NOISE);
+    }
+}
+
+Quaternion *eskf_get_quaternion(EskfFilter *filter)
+{
+    return &(filter->q);
+}
+
+void eskf_get_euler(EskfFilter *filter, float32_t euler[3])
+{
+    quat_to_euler(&(filter->q), euler);
+}
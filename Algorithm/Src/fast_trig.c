@@ -0,0 +1,143 @@
+#include "fast_trig.h"
+#include <math.h>
+
+#define FAST_PI (3.14159265358979f)
+#define FAST_PI_2 (1.57079632679490f)
+#define FAST_2_OVER_PI (0.636619772367581f)
+
+// pi / 2 in three parts, k * FAST_PI_2_A is exact for |k| < 2^16 (cody-waite)
+#define FAST_PI_2_A (1.5703125f)
+#define FAST_PI_2_B (4.837512969970703125e-4f)
+#define FAST_PI_2_C (7.54978995489188216e-8f)
+
+// 1.5 * 2^23, adding and subtracting it rounds to the nearest integer
+#define FAST_ROUND_MAGIC (12582912.0f)
+
+/*
+ **************************************************************************
+ * polynomial kernels
+ **************************************************************************
+ */
+// sin and cos on [-pi/4, pi/4], cephes minimax coefficients
+static inline float32_t sin_kernel(float32_t r, float32_t z)
+{
+    return ((-1.9515295891e-4f * z + 8.3321608736e-3f) * z - 1.6666654611e-1f) * z * r + r;
+}
+
+static inline float32_t cos_kernel(float32_t z)
+{
+    return ((2.443315711809948e-5f * z - 1.388731625493765e-3f) * z + 4.166664568298827e-2f) * z * z - 0.5f * z + 1.0f;
+}
+
+// atan on [0, 1]: t + t z P(z), z = t^2
+static inline float32_t atan_kernel(float32_t t)
+{
+    float32_t z = t * t;
+    float32_t p = 0x1.01fd88p-8f;
+    p = p * z - 0x1.4c3c60p-6f;
+    p = p * z + 0x1.93a2c0p-5f;
+    p = p * z - 0x1.491f0ep-4f;
+    p = p * z + 0x1.bd7368p-4f;
+    p = p * z - 0x1.24051ep-3f;
+    p = p * z + 0x1.99935ep-3f;
+    p = p * z - 0x1.55555p-2f;
+    return t + t * z * p;
+}
+
+// asin on [0, 0.5]: s + s z P(z), z = s^2
+static inline float32_t asin_kernel(float32_t s, float32_t z)
+{
+    float32_t p = 0x1.3af7d8p-5f;
+    p = p * z + 0x1.b059dp-6f;
+    p = p * z + 0x1.70d7dcp-5f;
+    p = p * z + 0x1.33261ap-4f;
+    p = p * z + 0x1.55555ep-3f;
+    return s + s * z * p;
+}
+
+/*
+ **************************************************************************
+ * sin and cos
+ **************************************************************************
+ */
+void fast_sin_cos(float32_t x, float32_t *sin_val, float32_t *cos_val)
+{
+    // x = k pi/2 + r, |r| <= pi/4
+    float32_t k = (x * FAST_2_OVER_PI + FAST_ROUND_MAGIC) - FAST_ROUND_MAGIC;
+    float32_t r = ((x - k * FAST_PI_2_A) - k * FAST_PI_2_B) - k * FAST_PI_2_C;
+    int32_t quadrant = (int32_t)k;
+
+    float32_t z = r * r;
+    float32_t s = sin_kernel(r, z);
+    float32_t c = cos_kernel(z);
+
+    // quadrant 0: (s, c), 1: (c, -s), 2: (-s, -c), 3: (-c, s)
+    float32_t sin_out = (quadrant & 1) ? c : s;
+    float32_t cos_out = (quadrant & 1) ? s : c;
+    *sin_val = (quadrant & 2) ? -sin_out : sin_out;
+    *cos_val = ((quadrant + 1) & 2) ? -cos_out : cos_out;
+}
+
+float32_t fast_sin(float32_t x)
+{
+    float32_t s, c;
+    fast_sin_cos(x, &s, &c);
+    return s;
+}
+
+float32_t fast_cos(float32_t x)
+{
+    float32_t s, c;
+    fast_sin_cos(x, &s, &c);
+    return c;
+}
+
+/*
+ **************************************************************************
+ * inverse functions
+ **************************************************************************
+ */
+float32_t fast_atan2(float32_t y, float32_t x)
+{
+    float32_t ax = fabsf(x);
+    float32_t ay = fabsf(y);
+
+    // reduce to t = min / max in [0, 1]
+    int swap = ay > ax;
+    float32_t num = swap ? ax : ay;
+    float32_t den = swap ? ay : ax;
+    float32_t t = (den > 0.0f) ? num / den : 0.0f;
+
+    float32_t angle = atan_kernel(t);
+    angle = swap ? FAST_PI_2 - angle : angle;
+    angle = signbit(x) ? FAST_PI - angle : angle;
+    return copysignf(angle, y);
+}
+
+float32_t fast_asin(float32_t x)
+{
+    float32_t ax = fminf(fabsf(x), 1.0f);
+
+    // |x| >= 0.5: asin(x) = pi/2 - 2 asin(sqrt((1 - |x|) / 2))
+    int large = ax >= 0.5f;
+    float32_t z = large ? (1.0f - ax) * 0.5f : ax * ax;
+    float32_t s = large ? sqrtf(z) : ax;
+
+    float32_t p = asin_kernel(s, z);
+    float32_t angle = large ? FAST_PI_2 - 2.0f * p : p;
+    return copysignf(angle, x);
+}
+
+float32_t fast_acos(float32_t x)
+{
+    float32_t ax = fminf(fabsf(x), 1.0f);
+
+    // |x| >= 0.5: acos(|x|) = 2 asin(sqrt((1 - |x|) / 2)), no cancellation near 1
+    int large = ax >= 0.5f;
+    float32_t z = large ? (1.0f - ax) * 0.5f : ax * ax;
+    float32_t s = large ? sqrtf(z) : ax;
+
+    float32_t p = asin_kernel(s, z);
+    float32_t angle = large ? 2.0f * p : FAST_PI_2 - p;
+    return signbit(x) ? FAST_PI - angle : angle;
+}
@@ -0,0 +1,119 @@
+#include "gyro_cal.h"
+#include <string.h>
+#include <math.h>
+
+#define GYRO_CAL_MAX_RATE (0.05f)  // rad/s, a sample further than this from the bias restarts the window
+#define GYRO_CAL_MAX_ACCEL (0.03f) // g, a sample with ||a| - 1| above this restarts the window
+#define GYRO_CAL_MAX_BIAS (0.05f)  // rad/s, largest plausible bias, about 3 deg/s
+#define GYRO_CAL_MAX_STEP (0.002f) // rad/s, largest change per window once calibrated, thermal drift is slower
+
+static inline void window_reset(GyroCal *cal)
+{
+    cal->count = 0;
+    memset(cal->mean, 0, sizeof(cal->mean));
+    memset(cal->m2, 0, sizeof(cal->m2));
+}
+
+// 1 when the sample may belong to a still window
+static inline uint8_t sample_still(const GyroCal *cal, const float32_t gyro[3], const float32_t accel[3])
+{
+    for (int i = 0; i < 3; i++)
+    {
+        if (fabsf(gyro[i] - cal->bias[i]) > GYRO_CAL_MAX_RATE)
+        {
+            return 0;
+        }
+    }
+
+    float32_t a_norm;
+    arm_sqrt_f32(accel[0] * accel[0] + accel[1] * accel[1] + accel[2] * accel[2], &a_norm);
+    return fabsf(a_norm - 1.0f) <= GYRO_CAL_MAX_ACCEL;
+}
+
+void gyro_cal_init(GyroCal *cal, const float32_t bias[3], uint32_t window)
+{
+    memcpy(cal->bias, bias, sizeof(cal->bias));
+    cal->window = window;
+    window_reset(cal);
+
+    cal->noise = 0.0f;
+    cal->bias_sigma = 0.0f;
+    cal->accepted = 0;
+    cal->rejected = 0;
+    cal->valid = 0;
+    memset(cal->jump, 0, sizeof(cal->jump));
+    cal->jumps = 0;
+}
+
+uint8_t gyro_cal_update(GyroCal *cal, const float32_t gyro[3], const float32_t accel[3])
+{
+    if (!sample_still(cal, gyro, accel))
+    {
+        window_reset(cal);
+        return 0;
+    }
+
+    // running mean and sum of squared deviations
+    cal->count++;
+    float32_t scale = 1.0f / (float32_t)cal->count;
+    for (int i = 0; i < 3; i++)
+    {
+        float32_t delta = gyro[i] - cal->mean[i];
+        cal->mean[i] += delta * scale;
+        cal->m2[i] += delta * (gyro[i] - cal->mean[i]);
+    }
+    if (cal->count < cal->window)
+    {
+        return 0;
+    }
+
+    // a slow turn passes the per-sample and the variance check,
+    // once calibrated it shows up as a jump of the bias, before that only implausible ones are caught
+    float32_t variance = 0.0f;
+    uint8_t plausible = 1, near = 1, repeat = 1;
+    for (int i = 0; i < 3; i++)
+    {
+        variance = fmaxf(variance, cal->m2[i] / (float32_t)(cal->count - 1));
+        plausible &= fabsf(cal->mean[i]) <= GYRO_CAL_MAX_BIAS;
+        near &= fabsf(cal->mean[i] - cal->bias[i]) <= GYRO_CAL_MAX_STEP;
+        repeat &= fabsf(cal->mean[i] - cal->jump[i]) <= GYRO_CAL_MAX_STEP;
+    }
+    uint8_t still = variance <= GYRO_CAL_STILL_SIGMA * GYRO_CAL_STILL_SIGMA;
+
+    // a bias that really moved, after a knock or a missed warm up, is still there the next windows
+    if (cal->valid && plausible && still && !near)
+    {
+        cal->jumps = (cal->jumps > 0 && repeat) ? cal->jumps + 1 : 1;
+        memcpy(cal->jump, cal->mean, sizeof(cal->jump));
+        near = cal->jumps >= GYRO_CAL_RELEARN;
+    }
+    else
+    {
+        cal->jumps = 0;
+    }
+
+    uint8_t accepted = 0;
+    if (plausible && still && (near || !cal->valid))
+    {
+        memcpy(cal->bias, cal->mean, sizeof(cal->bias));
+        arm_sqrt_f32(variance, &cal->noise);
+        cal->bias_sigma = cal->noise / sqrtf((float32_t)cal->count);
+        cal->accepted++;
+        cal->valid = 1;
+        accepted = 1;
+    }
+    else
+    {
+        cal->rejected++;
+    }
+
+    window_reset(cal);
+    return accepted;
+}
+
+void gyro_cal_apply(const GyroCal *cal, float32_t gyro[3])
+{
+    gyro[0] -= cal->bias[0];
+    gyro[1] -= cal->bias[1];
+    gyro[2] -= cal->bias[2];
+}
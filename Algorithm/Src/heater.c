@@ -0,0 +1,86 @@
+#include "heater.h"
+#include <math.h>
+#include <stddef.h>
+
+void heater_init(Heater *heater, float target)
+{
+    if (heater == NULL)
+    {
+        return;
+    }
+
+    pid_init(&heater->pid, HEATER_KP, HEATER_KI, 0.0f, HEATER_I_LIMIT, 1.0f);
+    heater->target = target;
+    heater->temp = 0.0f;
+    heater->duty = 0.0f;
+    heater->state = HEATER_WARMUP;
+    heater->in_band = 0;
+    heater->time = 0;
+    heater->ready_at = 0;
+    heater->ready = 0;
+}
+
+float heater_update(Heater *heater, float temp)
+{
+    if (heater == NULL)
+    {
+        return 0.0f;
+    }
+
+    heater->temp = temp;
+    heater->time++;
+    float error = heater->target - temp;
+
+    // a runaway heater or a broken reading latches it off
+    if (heater->state == HEATER_FAULT || error < -HEATER_OVERHEAT)
+    {
+        heater->state = HEATER_FAULT;
+        heater->ready = 0;
+        heater->duty = 0.0f;
+        return heater->duty;
+    }
+
+    if (heater->state == HEATER_WARMUP)
+    {
+        if (error > HEATER_WARMUP_BAND)
+        {
+            heater->duty = 1.0f;
+            return heater->duty;
+        }
+        // arriving from full power, the integral starts empty so it does not carry the warm-up into an overshoot
+        state_reset(&heater->pid);
+        heater->state = HEATER_HOLD;
+    }
+
+    // hold, the duty cannot go negative so a clamped output keeps the integral from winding below zero
+    float output = pid_calculate(&heater->pid, heater->target, temp);
+    if (heater->pid.i_out < 0.0f)
+    {
+        heater->pid.i_out = 0.0f;
+    }
+    heater->duty = output > 0.0f ? output : 0.0f;
+
+    // ready once settled, lost on a large excursion (cold air, a long stop)
+    if (fabsf(error) <= HEATER_READY_BAND)
+    {
+        if (heater->in_band < HEATER_READY_TIME)
+        {
+            heater->in_band++;
+        }
+        if (heater->in_band >= HEATER_READY_TIME && !heater->ready)
+        {
+            heater->ready = 1;
+            heater->ready_at = heater->time;
+        }
+    }
+    else
+    {
+        heater->in_band = 0;
+        if (fabsf(error) > HEATER_LOST_BAND)
+        {
+            heater->ready = 0;
+        }
+    }
+
+    return heater->duty;
+}
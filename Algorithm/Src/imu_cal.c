@@ -0,0 +1,66 @@
+#include "imu_cal.h"
+#include <string.h>
+
+void imu_cal_init(ImuCal *cal)
+{
+    memset(cal, 0, sizeof(ImuCal));
+    cal->accel_matrix[0] = 1.0f;
+    cal->accel_matrix[4] = 1.0f;
+    cal->accel_matrix[8] = 1.0f;
+}
+
+void imu_cal_accel(const ImuCal *cal, const float32_t raw[3], float32_t accel[3])
+{
+    float32_t centered[3] = {raw[0] - cal->accel_offset[0],
+                             raw[1] - cal->accel_offset[1],
+                             raw[2] - cal->accel_offset[2]};
+
+    // 3x3 times 3x1, the instances only wrap the arrays
+    arm_matrix_instance_f32 m, in, out;
+    arm_mat_init_f32(&m, 3, 3, (float32_t *)cal->accel_matrix);
+    arm_mat_init_f32(&in, 3, 1, centered);
+    arm_mat_init_f32(&out, 3, 1, accel);
+    arm_mat_mult_f32(&m, &in, &out);
+}
+
+void imu_cal_gyro_bias(const ImuCal *cal, float32_t temp, float32_t bias[3])
+{
+    if (cal->temp_num == 0)
+    {
+        memset(bias, 0, 3 * sizeof(float32_t));
+        return;
+    }
+
+    // clamp outside the calibrated range
+    if (cal->temp_num == 1 || temp <= cal->temp[0])
+    {
+        memcpy(bias, cal->gyro_bias[0], 3 * sizeof(float32_t));
+        return;
+    }
+    uint8_t last = cal->temp_num - 1;
+    if (temp >= cal->temp[last])
+    {
+        memcpy(bias, cal->gyro_bias[last], 3 * sizeof(float32_t));
+        return;
+    }
+
+    uint8_t i = 0;
+    while (temp > cal->temp[i + 1])
+    {
+        i++;
+    }
+    float32_t t = (temp - cal->temp[i]) / (cal->temp[i + 1] - cal->temp[i]);
+    for (int k = 0; k < 3; k++)
+    {
+        bias[k] = cal->gyro_bias[i][k] + t * (cal->gyro_bias[i + 1][k] - cal->gyro_bias[i][k]);
+    }
+}
+
+void imu_cal_gyro(const ImuCal *cal, const float32_t raw[3], float32_t temp, float32_t gyro[3])
+{
+    float32_t bias[3];
+    imu_cal_gyro_bias(cal, temp, bias);
+    gyro[0] = raw[0] - bias[0];
+    gyro[1] = raw[1] - bias[1];
+    gyro[2] = raw[2] - bias[2];
+}
@@ -1,27 +1,234 @@
 #include "kinematics.h"
+#include "fast_trig.h"
+#include <stddef.h>
+
+#ifndef PI
+#define PI (3.14159265358979f)
+#endif
 
 #ifndef SQRT_2
 #define SQRT_2 1.41421356237f
 #endif
 
-void kine_omni_decomposition(float32_t v_chassis[2], float32_t v_wheels[4]){
-    // v_chassis: (vc_x, vc_y)
-    // v_wheels: (vw_1, vw_2, vw_3, vw_4), be careful about positive direction of v wheels
+// wheel positions in half_length / half_width units, and the omni / mecanum drive direction of each wheel
+static const float32_t wheel_pos[KINE_WHEEL_NUM][2] = {{1.0f, -1.0f}, {1.0f, 1.0f}, {-1.0f, 1.0f}, {-1.0f, -1.0f}};
+static const float32_t wheel_dir[KINE_WHEEL_NUM][2] = {{1.0f, 1.0f}, {1.0f, -1.0f}, {1.0f, 1.0f}, {1.0f, -1.0f}};
+
+static inline float32_t wrap_pi(float32_t x)
+{
+    if (x > PI)
+    {
+        x -= 2 * PI;
+    }
+    else if (x < -PI)
+    {
+        x += 2 * PI;
+    }
+    return x;
+}
+
+// forward = (J^T J)^-1 J^T, J is rows x 3, written as 3 x rows
+static void kine_pseudo_inverse(const float32_t *j, uint16_t rows, float32_t *forward)
+{
+    float32_t jtj[3][3] = {{0.0f}};
+    for (uint16_t k = 0; k < rows; k++)
+    {
+        for (int r = 0; r < 3; r++)
+        {
+            for (int c = 0; c < 3; c++)
+            {
+                jtj[r][c] += j[k * 3 + r] * j[k * 3 + c];
+            }
+        }
+    }
+
+    // 3 x 3 inverse by cofactors, a degenerate geometry leaves the forward matrix zero
+    float32_t inv[3][3];
+    inv[0][0] = jtj[1][1] * jtj[2][2] - jtj[1][2] * jtj[2][1];
+    inv[0][1] = jtj[0][2] * jtj[2][1] - jtj[0][1] * jtj[2][2];
+    inv[0][2] = jtj[0][1] * jtj[1][2] - jtj[0][2] * jtj[1][1];
+    inv[1][0] = jtj[1][2] * jtj[2][0] - jtj[1][0] * jtj[2][2];
+    inv[1][1] = jtj[0][0] * jtj[2][2] - jtj[0][2] * jtj[2][0];
+    inv[1][2] = jtj[0][2] * jtj[1][0] - jtj[0][0] * jtj[1][2];
+    inv[2][0] = jtj[1][0] * jtj[2][1] - jtj[1][1] * jtj[2][0];
+    inv[2][1] = jtj[0][1] * jtj[2][0] - jtj[0][0] * jtj[2][1];
+    inv[2][2] = jtj[0][0] * jtj[1][1] - jtj[0][1] * jtj[1][0];
+    float32_t det = jtj[0][0] * inv[0][0] + jtj[0][1] * inv[1][0] + jtj[0][2] * inv[2][0];
+    float32_t inv_det = (det > 1e-12f || det < -1e-12f) ? 1.0f / det : 0.0f;
+
+    for (int r = 0; r < 3; r++)
+    {
+        for (uint16_t k = 0; k < rows; k++)
+        {
+            float32_t sum = 0.0f;
+            for (int c = 0; c < 3; c++)
+            {
+                sum += inv[r][c] * j[k * 3 + c];
+            }
+            forward[r * rows + k] = sum * inv_det;
+        }
+    }
+}
+
+void kine_init(KineInfo *kine, const KineConfig *config)
+{
+    if (kine == NULL || config == NULL)
+    {
+        return;
+    }
+
+    kine->config = *config;
+    float32_t *j = kine->inverse_data;
+    uint16_t rows = (config->type == KINE_SWERVE) ? 2 * KINE_WHEEL_NUM : KINE_WHEEL_NUM;
+
+    for (int i = 0; i < KINE_WHEEL_NUM; i++)
+    {
+        float32_t p_x = wheel_pos[i][0] * config->half_length;
+        float32_t p_y = wheel_pos[i][1] * config->half_width;
+
+        if (config->type == KINE_SWERVE)
+        {
+            // module velocity = v + wz x p, the wheel speed and steer angle follow per module
+            float32_t *row = &j[2 * i * 3];
+            row[0] = 1.0f;
+            row[1] = 0.0f;
+            row[2] = -p_y;
+            row[3] = 0.0f;
+            row[4] = 1.0f;
+            row[5] = p_x;
+        }
+        else
+        {
+            // wheel speed = sign / radius * d . (v + wz x p), d unit for omni, (1, +-1) for 45 deg mecanum rollers
+            float32_t d_x = wheel_dir[i][0];
+            float32_t d_y = wheel_dir[i][1];
+            float32_t scale = config->sign[i] / config->wheel_radius;
+            if (config->type == KINE_OMNI_X)
+            {
+                scale /= SQRT_2;
+            }
+            float32_t *row = &j[i * 3];
+            row[0] = scale * d_x;
+            row[1] = scale * d_y;
+            row[2] = scale * (p_x * d_y - p_y * d_x);
+        }
+    }
+
+    kine_pseudo_inverse(j, rows, kine->forward_data);
+    arm_mat_init_f32(&kine->inverse, rows, 3, kine->inverse_data);
+    arm_mat_init_f32(&kine->forward, 3, rows, kine->forward_data);
+}
+
+void kine_inverse(KineInfo *kine, float32_t v_chassis[3], float32_t w_wheels[KINE_WHEEL_NUM])
+{
+    // a swerve matrix has 8 rows, cmsis only checks sizes with ARM_MATH_MATRIX_CHECK
+    if (kine->config.type == KINE_SWERVE)
+    {
+        for (int i = 0; i < KINE_WHEEL_NUM; i++)
+        {
+            w_wheels[i] = 0.0f;
+        }
+        return;
+    }
 
-    float32_t v24 = ( v_chassis[0] - v_chassis[1]) / SQRT_2;
-    float32_t v13 = ( v_chassis[0] + v_chassis[1]) / SQRT_2;
-    v_wheels[0] = v13;
-    v_wheels[1] = v24;
-    v_wheels[2] = v13;
-    v_wheels[3] = v24;
+    arm_matrix_instance_f32 v, w;
+    arm_mat_init_f32(&v, 3, 1, v_chassis);
+    arm_mat_init_f32(&w, KINE_WHEEL_NUM, 1, w_wheels);
+    arm_mat_mult_f32(&kine->inverse, &v, &w);
+}
+
+void kine_forward(KineInfo *kine, float32_t w_wheels[KINE_WHEEL_NUM], float32_t v_chassis[3])
+{
+    if (kine->config.type == KINE_SWERVE)
+    {
+        v_chassis[0] = v_chassis[1] = v_chassis[2] = 0.0f;
+        return;
+    }
+
+    arm_matrix_instance_f32 w, v;
+    arm_mat_init_f32(&w, KINE_WHEEL_NUM, 1, w_wheels);
+    arm_mat_init_f32(&v, 3, 1, v_chassis);
+    arm_mat_mult_f32(&kine->forward, &w, &v);
+}
+
+void kine_swerve_inverse(KineInfo *kine, float32_t v_chassis[3], float32_t steer_now[KINE_WHEEL_NUM],
+                         float32_t w_wheels[KINE_WHEEL_NUM], float32_t steer[KINE_WHEEL_NUM])
+{
+    if (kine->config.type != KINE_SWERVE)
+    {
+        for (int i = 0; i < KINE_WHEEL_NUM; i++)
+        {
+            w_wheels[i] = 0.0f;
+            steer[i] = steer_now[i];
+        }
+        return;
+    }
+
+    float32_t v_module[2 * KINE_WHEEL_NUM];
+    arm_matrix_instance_f32 v, m;
+    arm_mat_init_f32(&v, 3, 1, v_chassis);
+    arm_mat_init_f32(&m, 2 * KINE_WHEEL_NUM, 1, v_module);
+    arm_mat_mult_f32(&kine->inverse, &v, &m);
+
+    for (int i = 0; i < KINE_WHEEL_NUM; i++)
+    {
+        float32_t v_x = v_module[2 * i];
+        float32_t v_y = v_module[2 * i + 1];
+
+        // shortest turn, at most 90 deg, the wheel reverses instead
+        float32_t target = steer_now[i];
+        if (v_x * v_x + v_y * v_y > KINE_SWERVE_HOLD * KINE_SWERVE_HOLD)
+        {
+            target = fast_atan2(v_y, v_x);
+            float32_t error = wrap_pi(target - steer_now[i]);
+            if (error > 0.5f * PI)
+            {
+                target -= PI;
+            }
+            else if (error < -0.5f * PI)
+            {
+                target += PI;
+            }
+        }
+        steer[i] = wrap_pi(target);
+
+        // drive along the current heading only, speed * cos(steer error), no push sideways while turning
+        float32_t sin_now, cos_now;
+        fast_sin_cos(steer_now[i], &sin_now, &cos_now);
+        w_wheels[i] = kine->config.sign[i] * (v_x * cos_now + v_y * sin_now) / kine->config.wheel_radius;
+    }
+}
+
+void kine_swerve_forward(KineInfo *kine, float32_t w_wheels[KINE_WHEEL_NUM], float32_t steer[KINE_WHEEL_NUM],
+                         float32_t v_chassis[3])
+{
+    if (kine->config.type != KINE_SWERVE)
+    {
+        v_chassis[0] = v_chassis[1] = v_chassis[2] = 0.0f;
+        return;
+    }
+
+    float32_t v_module[2 * KINE_WHEEL_NUM];
+    for (int i = 0; i < KINE_WHEEL_NUM; i++)
+    {
+        float32_t sin_steer, cos_steer;
+        fast_sin_cos(steer[i], &sin_steer, &cos_steer);
+        float32_t speed = kine->config.sign[i] * w_wheels[i] * kine->config.wheel_radius;
+        v_module[2 * i] = speed * cos_steer;
+        v_module[2 * i + 1] = speed * sin_steer;
+    }
+
+    arm_matrix_instance_f32 m, v;
+    arm_mat_init_f32(&m, 2 * KINE_WHEEL_NUM, 1, v_module);
+    arm_mat_init_f32(&v, 3, 1, v_chassis);
+    arm_mat_mult_f32(&kine->forward, &m, &v);
 }
 
 void kine_gimbal_follow(float32_t yaw_angle, float32_t v_gimbal_frame[2], float32_t v_chassis_frame[2]) {
     // [vc_x] = [  cos(yaw) - sin(yaw) ] [vg_x]
     // [vc_y]   [  sin(yaw)   cos(yaw) ] [vg_y]
-    float32_t cos_yaw = arm_cos_f32(yaw_angle);
-    float32_t sin_yaw = arm_sin_f32(yaw_angle);
+    float32_t cos_yaw, sin_yaw;
+    fast_sin_cos(yaw_angle, &sin_yaw, &cos_yaw);
     v_chassis_frame[0] = cos_yaw * v_gimbal_frame[0] - sin_yaw * v_gimbal_frame[1];
     v_chassis_frame[1] = sin_yaw * v_gimbal_frame[0] + cos_yaw * v_gimbal_frame[1];
 }
-
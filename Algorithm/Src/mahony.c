@@ -45,6 +45,33 @@ static inline void cross_product(float32_t a[3], float32_t b[3], float32_t resul
     result[2] = a[0] * b[1] - a[1] * b[0];
 }
 
+// scale of kp and of the integral input, 1 when the accelerometer is pure gravity
+static float32_t accel_trust(MahonyFilter *filter, float32_t gyro[3], float32_t accel[3])
+{
+    float32_t trust = 1.0f;
+
+    // linear acceleration: |a| away from 1 g
+    if (filter->accel_band > 0.0f)
+    {
+        float32_t a_norm;
+        arm_sqrt_f32(accel[0] * accel[0] + accel[1] * accel[1] + accel[2] * accel[2], &a_norm);
+        trust = 1.0f - fabsf(a_norm - 1.0f) / filter->accel_band;
+        if (trust <= 0.0f)
+        {
+            return 0.0f;
+        }
+    }
+
+    // centripetal acceleration and a lagging error while rotating fast
+    if (filter->rate_band > 0.0f)
+    {
+        float32_t rate2 = gyro[0] * gyro[0] + gyro[1] * gyro[1] + gyro[2] * gyro[2];
+        trust /= 1.0f + rate2 / (filter->rate_band * filter->rate_band);
+    }
+
+    return trust;
+}
+
 void mahony_compute_error(MahonyFilter *filter, float32_t measured[3], float32_t error[3])
 {
     // normalize measured acceleration
@@ -72,14 +99,25 @@ void mahony_init(MahonyFilter *filter,
     filter->ki = ki;
     filter->i_limit = i_limit;
     filter->sample_freq = sample_freq;
+    filter->integrator = MAHONY_INTEGRATOR_EULER;
+    filter->accel_band = 0.0f;
+    filter->rate_band = 0.0f;
+    filter->kp_effective = kp;
 }
 
 void mahony_update(MahonyFilter *filter, float32_t gyro[3], float32_t accel[3])
+{
+    mahony_update_dt(filter, gyro, accel, 1.0f / filter->sample_freq);
+}
+
+void mahony_update_dt(MahonyFilter *filter, float32_t gyro[3], float32_t accel[3], float32_t dt)
 {
     // integtral time scale
-    float32_t time_scale = 1.0f / filter->sample_freq;
-    float32_t kp = filter->kp;
+    float32_t time_scale = dt;
+    float32_t trust = accel_trust(filter, gyro, accel);
+    float32_t kp = filter->kp * trust;
     float32_t ki = filter->ki;
+    filter->kp_effective = kp;
 
     // compute error
     float32_t error[3];
@@ -90,25 +128,30 @@ void mahony_update(MahonyFilter *filter, float32_t gyro[3], float32_t accel[3])
     for (int i = 0; i < 3; i++)
     {
         // update integral term
-        filter->integral[i] += error[i];
+        filter->integral[i] += trust * error[i];
         filter->integral[i] = val_limit_float(filter->integral[i], -filter->i_limit, filter->i_limit);
 
         // w_correct = w + kp * error + ki * \int error
         w_corrected[i] = gyro[i] + kp * error[i] + ki * filter->integral[i];
     }
 
-    // get quaternion derivative
-    Quaternion q_dot;
-    quat_derivative(&(filter->q), w_corrected, &q_dot);
-
-    // euler method to update quaternion
-    (filter->q).q_w += q_dot.q_w * time_scale;
-    (filter->q).q_x += q_dot.q_x * time_scale;
-    (filter->q).q_y += q_dot.q_y * time_scale;
-    (filter->q).q_z += q_dot.q_z * time_scale;
-
-    // normalize
-    quat_normalize(&filter->q);
+    // update and normalize quaternion
+    switch (filter->integrator)
+    {
+    case MAHONY_INTEGRATOR_RK2:
+        quat_integrate_rk2(&filter->q, w_corrected, time_scale);
+        break;
+    case MAHONY_INTEGRATOR_RK4:
+        quat_integrate_rk4(&filter->q, w_corrected, time_scale);
+        break;
+    case MAHONY_INTEGRATOR_EXP:
+        quat_integrate_exp(&filter->q, w_corrected, time_scale);
+        break;
+    case MAHONY_INTEGRATOR_EULER:
+    default:
+        quat_integrate_euler(&filter->q, w_corrected, time_scale);
+        break;
+    }
 }
 
 Quaternion *mahony_get_quaternion(MahonyFilter *filter)
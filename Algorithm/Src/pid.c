@@ -17,6 +17,21 @@ static inline float val_limit_float(float x, float min, float max)
     }
 }
 
+void pid_init(PidInfo *pid, float kp, float ki, float kd, float i_limit, float out_limit)
+{
+    if (pid == NULL)
+    {
+        return;
+    }
+
+    pid->kp = kp;
+    pid->ki = ki;
+    pid->kd = kd;
+    pid->i_limit = i_limit;
+    pid->out_limit = out_limit;
+    state_reset(pid);
+}
+
 void state_reset(PidInfo *pid)
 {
     pid->target = 0;
@@ -0,0 +1,176 @@
+#include "pll.h"
+#include <stddef.h>
+
+#ifndef PI
+#define PI (3.14159265358979f)
+#endif
+
+static inline float wrap_two_pi(float x)
+{
+    if (x >= 2 * PI)
+    {
+        x -= 2 * PI;
+    }
+    else if (x < 0.0f)
+    {
+        x += 2 * PI;
+    }
+    return x;
+}
+
+static inline float wrap_pi(float x)
+{
+    if (x > PI)
+    {
+        x -= 2 * PI;
+    }
+    else if (x < -PI)
+    {
+        x += 2 * PI;
+    }
+    return x;
+}
+
+void pll_init(PllInfo *pll, float jerk_noise)
+{
+    if (pll == NULL)
+    {
+        return;
+    }
+
+    pll->jerk_noise = jerk_noise;
+    pll->bias_noise = PLL_BIAS_NOISE;
+    pll->angle_noise = PLL_ANGLE_NOISE;
+    pll->rpm_noise = PLL_RPM_NOISE;
+    pll_reset(pll);
+}
+
+void pll_reset(PllInfo *pll)
+{
+    pll->angle = 0.0f;
+    pll->velocity = 0.0f;
+    pll->acceleration = 0.0f;
+    pll->rpm_bias = 0.0f;
+    pll->error = 0.0f;
+    pll->locked = 0;
+}
+
+// scalar measurement h . x with variance r
+static void pll_correct(PllInfo *pll, const float h[PLL_STATES], float innovation, float r)
+{
+    float (*p)[PLL_STATES] = pll->p;
+
+    float ph[PLL_STATES], s = r;
+    for (int i = 0; i < PLL_STATES; i++)
+    {
+        ph[i] = 0.0f;
+        for (int j = 0; j < PLL_STATES; j++)
+        {
+            ph[i] += p[i][j] * h[j];
+        }
+        s += h[i] * ph[i];
+    }
+    if (s <= 0.0f)
+    {
+        return;
+    }
+
+    float gain[PLL_STATES];
+    for (int i = 0; i < PLL_STATES; i++)
+    {
+        gain[i] = ph[i] / s;
+    }
+    pll->angle = wrap_two_pi(pll->angle + gain[0] * innovation);
+    pll->velocity += gain[1] * innovation;
+    pll->acceleration += gain[2] * innovation;
+    pll->rpm_bias += gain[3] * innovation;
+
+    // p -= k (p h)^t, kept symmetric
+    for (int i = 0; i < PLL_STATES; i++)
+    {
+        for (int j = i; j < PLL_STATES; j++)
+        {
+            p[i][j] -= gain[i] * ph[j];
+            p[j][i] = p[i][j];
+        }
+    }
+}
+
+float pll_update(PllInfo *pll, float angle, float velocity, float dt)
+{
+    static const float h_angle[PLL_STATES] = {1.0f, 0.0f, 0.0f, 0.0f};
+    static const float h_rpm[PLL_STATES] = {0.0f, 1.0f, 0.0f, 1.0f};
+
+    if (pll == NULL)
+    {
+        return velocity;
+    }
+
+    float (*p)[PLL_STATES] = pll->p;
+
+    // first frame or a gap in the feedback: take the measurement as it is
+    if (!pll->locked || dt < PLL_DT_MIN || dt > PLL_DT_MAX)
+    {
+        pll->angle = angle;
+        pll->velocity = velocity;
+        pll->acceleration = 0.0f;
+        pll->rpm_bias = 0.0f;
+        pll->error = 0.0f;
+        for (int i = 0; i < PLL_STATES; i++)
+        {
+            for (int j = 0; j < PLL_STATES; j++)
+            {
+                p[i][j] = 0.0f;
+            }
+        }
+        p[0][0] = pll->angle_noise;
+        p[1][1] = PLL_RPM_STEP * PLL_RPM_STEP;
+        p[2][2] = PLL_ACCEL_INIT * PLL_ACCEL_INIT;
+        p[3][3] = pll->rpm_noise;
+        pll->locked = 1;
+        return pll->velocity;
+    }
+
+    // predict with constant acceleration and bias
+    float dt2 = dt * dt;
+    pll->angle = wrap_two_pi(pll->angle + pll->velocity * dt + 0.5f * pll->acceleration * dt2);
+    pll->velocity += pll->acceleration * dt;
+
+    // p = f p f^t, f = [1 dt dt^2/2 0; 0 1 dt 0; 0 0 1 0; 0 0 0 1], rows then columns
+    float half = 0.5f * dt2;
+    for (int j = 0; j < PLL_STATES; j++)
+    {
+        p[0][j] += dt * p[1][j] + half * p[2][j];
+        p[1][j] += dt * p[2][j];
+    }
+    for (int i = 0; i < PLL_STATES; i++)
+    {
+        p[i][0] += dt * p[i][1] + half * p[i][2];
+        p[i][1] += dt * p[i][2];
+    }
+
+    // + white jerk and a wandering rpm bias over dt
+    float q = pll->jerk_noise, dt3 = dt2 * dt;
+    p[0][0] += q * dt3 * dt2 / 20.0f;
+    p[0][1] += q * dt3 * dt / 8.0f;
+    p[0][2] += q * dt3 / 6.0f;
+    p[1][1] += q * dt3 / 3.0f;
+    p[1][2] += q * dt2 / 2.0f;
+    p[2][2] += q * dt;
+    p[3][3] += pll->bias_noise * dt;
+    p[1][0] = p[0][1];
+    p[2][0] = p[0][2];
+    p[2][1] = p[1][2];
+
+    // angle, a step is far below half a turn at any motor speed so the error wraps into -pi ~ pi
+    pll->error = wrap_pi(angle - pll->angle);
+    pll_correct(pll, h_angle, pll->error, pll->angle_noise);
+
+    // rpm = velocity + rounding bias + noise
+    if (pll->rpm_noise > 0.0f)
+    {
+        pll_correct(pll, h_rpm, velocity - pll->velocity - pll->rpm_bias, pll->rpm_noise);
+    }
+
+    return pll->velocity;
+}
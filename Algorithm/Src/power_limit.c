@@ -0,0 +1,142 @@
+#include "power_limit.h"
+#include <stddef.h>
+#include <math.h>
+
+// estimate for base + s * dir, per motor
+static float power_at(const PowerLimit *power, const float base[POWER_WHEEL_NUM], const float dir[POWER_WHEEL_NUM],
+                      float s, const float velocity[POWER_WHEEL_NUM])
+{
+    float total = 0.0f;
+    for (int i = 0; i < POWER_WHEEL_NUM; i++)
+    {
+        float current = base[i] + s * dir[i];
+        float mechanical = power->kt * velocity[i] * current;
+        total += power->resistance * current * current + (mechanical > 0.0f ? mechanical : 0.0f) +
+                 power->static_power;
+    }
+    return total;
+}
+
+// largest s in [0, 1] with the estimate of base + s * dir under the limit, 0 when even base is over
+static float power_scale(const PowerLimit *power, const float base[POWER_WHEEL_NUM],
+                         const float dir[POWER_WHEEL_NUM], const float velocity[POWER_WHEEL_NUM])
+{
+    if (power_at(power, base, dir, 1.0f, velocity) <= power->limit)
+    {
+        return 1.0f;
+    }
+
+    // lo always fits, the result never exceeds the limit
+    float lo = 0.0f, hi = 1.0f;
+    for (int k = 0; k < POWER_SEARCH_STEPS; k++)
+    {
+        float mid = 0.5f * (lo + hi);
+        if (power_at(power, base, dir, mid, velocity) <= power->limit)
+        {
+            lo = mid;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+void power_limit_init(PowerLimit *power, float limit)
+{
+    if (power == NULL)
+    {
+        return;
+    }
+
+    *power = (PowerLimit)POWER_LIMIT_INIT(limit);
+}
+
+void power_limit_set_rotation(PowerLimit *power, const float rotation[POWER_WHEEL_NUM])
+{
+    float norm = 0.0f;
+    for (int i = 0; i < POWER_WHEEL_NUM; i++)
+    {
+        norm += rotation[i] * rotation[i];
+    }
+    norm = sqrtf(norm);
+
+    for (int i = 0; i < POWER_WHEEL_NUM; i++)
+    {
+        power->rotation[i] = norm > 0.0f ? rotation[i] / norm : 0.0f;
+    }
+}
+
+float power_limit_estimate(const PowerLimit *power, const float current[POWER_WHEEL_NUM],
+                           const float velocity[POWER_WHEEL_NUM])
+{
+    static const float zero[POWER_WHEEL_NUM] = {0.0f};
+    return power_at(power, zero, current, 1.0f, velocity);
+}
+
+float power_limit_apply(PowerLimit *power, float current[POWER_WHEEL_NUM], const float measured[POWER_WHEEL_NUM])
+{
+    static const float zero[POWER_WHEEL_NUM] = {0.0f};
+
+    // speeds at the end of the hold
+    float velocity[POWER_WHEEL_NUM];
+    for (int i = 0; i < POWER_WHEEL_NUM; i++)
+    {
+        velocity[i] = 2.0f * measured[i] - power->velocity_last[i];
+        power->velocity_last[i] = measured[i];
+    }
+
+    power->power_raw = power_limit_estimate(power, current, velocity);
+    power->scale[0] = power->scale[1] = 1.0f;
+    if (power->power_raw <= power->limit)
+    {
+        power->power = power->power_raw;
+        return power->power;
+    }
+    power->limited++;
+
+    // split along the spin pattern: rotation = (i . r) r, translation = i - rotation
+    float along = 0.0f;
+    for (int i = 0; i < POWER_WHEEL_NUM; i++)
+    {
+        along += current[i] * power->rotation[i];
+    }
+
+    float first[POWER_WHEEL_NUM], second[POWER_WHEEL_NUM];
+    for (int i = 0; i < POWER_WHEEL_NUM; i++)
+    {
+        float rotation = along * power->rotation[i];
+        switch (power->priority)
+        {
+        case POWER_TRANSLATION_FIRST:
+            first[i] = current[i] - rotation;
+            second[i] = rotation;
+            break;
+        case POWER_ROTATION_FIRST:
+            first[i] = rotation;
+            second[i] = current[i] - rotation;
+            break;
+        case POWER_UNIFORM:
+        default:
+            first[i] = current[i];
+            second[i] = 0.0f;
+            break;
+        }
+    }
+
+    // the priority part alone, then the other part with what is left
+    power->scale[0] = power_scale(power, zero, first, velocity);
+    for (int i = 0; i < POWER_WHEEL_NUM; i++)
+    {
+        first[i] *= power->scale[0];
+    }
+    power->scale[1] = power_scale(power, first, second, velocity);
+    for (int i = 0; i < POWER_WHEEL_NUM; i++)
+    {
+        current[i] = first[i] + power->scale[1] * second[i];
+    }
+
+    power->power = power_limit_estimate(power, current, velocity);
+    return power->power;
+}
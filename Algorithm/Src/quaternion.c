@@ -1,4 +1,5 @@
 #include "quaternion.h"
+#include "fast_trig.h"
 #include <math.h>
 
 #define QUAT_EPSILON (1.0e-6f) // threshold
@@ -169,13 +170,86 @@ void quat_derivative(Quaternion *q, float32_t w[3], Quaternion *result)
     result->q_z = 0.5f * (w_z * q_w + w_y * q_x - w_x * q_y);
 }
 
+// quaternion integration
+static inline void quat_add_scaled(Quaternion *q, Quaternion *dq, float32_t scale, Quaternion *result)
+{
+    result->q_w = q->q_w + dq->q_w * scale;
+    result->q_x = q->q_x + dq->q_x * scale;
+    result->q_y = q->q_y + dq->q_y * scale;
+    result->q_z = q->q_z + dq->q_z * scale;
+}
+
+void quat_integrate_euler(Quaternion *q, float32_t w[3], float32_t dt)
+{
+    Quaternion q_dot;
+    quat_derivative(q, w, &q_dot);
+    quat_add_scaled(q, &q_dot, dt, q);
+    quat_normalize(q);
+}
+
+void quat_integrate_rk2(Quaternion *q, float32_t w[3], float32_t dt)
+{
+    Quaternion k1, k2, q_mid;
+    quat_derivative(q, w, &k1);
+    quat_add_scaled(q, &k1, 0.5f * dt, &q_mid);
+    quat_derivative(&q_mid, w, &k2);
+    quat_add_scaled(q, &k2, dt, q);
+    quat_normalize(q);
+}
+
+void quat_integrate_rk4(Quaternion *q, float32_t w[3], float32_t dt)
+{
+    Quaternion k1, k2, k3, k4, q_tmp;
+    quat_derivative(q, w, &k1);
+    quat_add_scaled(q, &k1, 0.5f * dt, &q_tmp);
+    quat_derivative(&q_tmp, w, &k2);
+    quat_add_scaled(q, &k2, 0.5f * dt, &q_tmp);
+    quat_derivative(&q_tmp, w, &k3);
+    quat_add_scaled(q, &k3, dt, &q_tmp);
+    quat_derivative(&q_tmp, w, &k4);
+
+    float32_t scale = dt / 6.0f;
+    q->q_w += (k1.q_w + 2.0f * (k2.q_w + k3.q_w) + k4.q_w) * scale;
+    q->q_x += (k1.q_x + 2.0f * (k2.q_x + k3.q_x) + k4.q_x) * scale;
+    q->q_y += (k1.q_y + 2.0f * (k2.q_y + k3.q_y) + k4.q_y) * scale;
+    q->q_z += (k1.q_z + 2.0f * (k2.q_z + k3.q_z) + k4.q_z) * scale;
+    quat_normalize(q);
+}
+
+void quat_integrate_exp(Quaternion *q, float32_t w[3], float32_t dt)
+{
+    // q = q ⊗ [cos(|h|), sin(|h|) h / |h|], h = w dt / 2
+    float32_t h[3] = {0.5f * w[0] * dt, 0.5f * w[1] * dt, 0.5f * w[2] * dt};
+    float32_t theta_square = quat_vector_norm_squared(h, 3);
+    float32_t cos_theta, sinc;
+    if (theta_square > QUAT_EPSILON)
+    {
+        float32_t theta, sin_theta;
+        arm_sqrt_f32(theta_square, &theta);
+        fast_sin_cos(theta, &sin_theta, &cos_theta);
+        sinc = sin_theta / theta;
+    }
+    else
+    {
+        // taylor series, exact to float precision for theta < 1e-3
+        cos_theta = 1.0f - 0.5f * theta_square;
+        sinc = 1.0f - theta_square * (1.0f / 6.0f);
+    }
+
+    Quaternion dq = {.q_w = cos_theta, .q_x = h[0] * sinc, .q_y = h[1] * sinc, .q_z = h[2] * sinc};
+    Quaternion result;
+    quat_multiply(q, &dq, &result);
+    *q = result;
+    quat_normalize(q);
+}
+
 // quaterion and vector rotation
 void quat_from_axis_angle(float32_t axis[3], float32_t angle, Quaternion *q)
 {
     // get sin and cos
     float32_t half_angle = angle * 0.5f;
     float32_t sin_half, cos_half;
-    arm_sin_cos_f32(half_angle, &sin_half, &cos_half);
+    fast_sin_cos(half_angle, &sin_half, &cos_half);
 
     // normalize the ortation axis
     float32_t axis_norm = quat_vector_norm(axis, 3);
@@ -210,7 +284,7 @@ void quat_to_axis_angle(Quaternion *q, float32_t axis[3], float32_t *angle)
         {
             q_w_over_norm = -1.0f;
         }
-        *angle = 2 * acosf(q_w_over_norm);
+        *angle = 2 * fast_acos(q_w_over_norm);
 
         // get rotation axis
         float32_t sin_half_square = 1.0f - (q->q_w * q->q_w) / (norm * norm);
@@ -324,7 +398,7 @@ void quat_to_euler(Quaternion *q, float32_t euler[3])
     // roll (x-axis rotation)
     float32_t sinr_cosp = 2.0f * (q_w * q_x + q_y * q_z);
     float32_t cosr_cosp = 1.0f - 2.0f * (q_x * q_x + q_y * q_y);
-    euler[2] = atan2f(sinr_cosp, cosr_cosp);
+    euler[2] = fast_atan2(sinr_cosp, cosr_cosp);
 
     // pitch (y-axis rotation)
     float32_t sinp = 2.0f * (q_w * q_y - q_z * q_x);
@@ -336,10 +410,10 @@ void quat_to_euler(Quaternion *q, float32_t euler[3])
     {
         sinp = -1.0f;
     }
-    euler[1] = asinf(sinp);
+    euler[1] = fast_asin(sinp);
 
     // yaw (z-axis rotation)
     float32_t siny_cosp = 2.0f * (q_w * q_z + q_x * q_y);
     float32_t cosy_cosp = 1.0f - 2.0f * (q_y * q_y + q_z * q_z);
-    euler[0] = atan2f(siny_cosp, cosy_cosp);
+    euler[0] = fast_atan2(siny_cosp, cosy_cosp);
 }
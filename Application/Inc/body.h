@@ -5,6 +5,7 @@
 
 // application body task
 void body_task(void);
+uint8_t body_is_spinning(void); // 1 while the spinning top mode is selected
 
 // useful functions
 // void set_body_target(float v_fr, float v_fl, float v_bl, float v_br);
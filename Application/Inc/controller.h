@@ -1,9 +1,16 @@
 #ifndef __CONTROLLER_H__
 #define __CONTROLLER_H__
 
+#include "power_limit.h"
+
 void set_body_velocity(float v_fr, float v_fl, float v_bl, float v_br);
-void set_neck_position(float pos_target, float pos_measure, float v_measure);
+void set_body_power_rotation(const float rotation[4]); // wheel speed pattern of a pure spin, for the power priority
+// w_chassis: chassis yaw rate when the targets are in the world frame, 0 in the encoder frame
+void set_neck_position(float pos_target, float pos_measure, float v_measure, float w_chassis);
 void set_head_command(float pos_pitch_target, float pos_pitch_measure,
                       float vel_pitch_measure, float v_fric_l, float v_fric_r, float v_trigger);
 
+// global variables
+extern PowerLimit body_power;
+
 #endif // __CONTROLLER_H__
@@ -0,0 +1,55 @@
+#ifndef __SCHEDULER_H__
+#define __SCHEDULER_H__
+
+#include <stdint.h>
+
+/*
+ * single-tick rate-monotonic scheduler, TIM4 at 1000 Hz
+ * every tick runs the table top to bottom: imu, filter, neck, head, then body every 8th tick,
+ * then flushes the staged can commands at once
+ * the tick only starts the imu burst, the spi dma interrupt decodes it and pends PendSV,
+ * scheduler_control filters it there and runs the control tasks, so they see the imu sample of the same tick
+ * without a wait
+ * the tick and PendSV share one nvic priority below the can / dbus / spi ingest interrupts, so ingest preempts both
+ * and the ingest interrupts only decode
+ */
+
+#define SCHED_TICK_HZ (1000)
+#define SCHED_TICK_US (1000000 / SCHED_TICK_HZ)
+
+typedef enum
+{
+    SCHED_IMU = 0,
+    SCHED_FILTER,
+    SCHED_NECK,
+    SCHED_HEAD,
+    SCHED_BODY,
+
+    SCHED_TASK_NUM
+} SchedTask;
+
+typedef struct
+{
+    void (*task)(void);
+    uint16_t divider;  // run every divider ticks
+    uint16_t offset;   // tick phase within the divider
+    uint16_t deadline; // us after the tick start
+    uint8_t profile;   // ProfileTask slot in profile_table
+} SchedEntry;
+
+typedef struct
+{
+    uint32_t tick;                 // ticks run
+    uint32_t lost;                 // ticks lost because a previous tick overran its period
+    uint32_t imu_late;             // ticks whose imu burst was still running at the next tick
+    uint32_t miss[SCHED_TASK_NUM]; // task finished after its deadline
+    uint32_t latency_max;          // us, tick start to the end of the last task
+} SchedStat;
+
+void scheduler_tick(void);    // TIM4 update interrupt
+void scheduler_control(void); // PendSV
+
+// global variables
+extern SchedStat sched_stat;
+
+#endif // __SCHEDULER_H__
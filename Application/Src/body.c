@@ -13,24 +13,44 @@ battery
 */
 
 #define VELOCITY_SCALE (2.0f)
+#define SPIN_RATE (6.0f)         // rad/s, spinning top chassis rate
+#define BODY_PERIOD (0.008f)     // s, body_task runs at 125 Hz
+#define SPIN_DRIVE_LEAD (0.030f) // s, wheel velocity loop lag the drive direction is turned ahead by
 
-#define WHEEL_RADIUS (0.10f) // in meters
-#define SIGN_V_FR (-1.0f)    // front right velocity sign
-#define SIGN_V_FL (1.0f)     // front left velocity sign
-#define SIGN_V_BL (1.0f)     // back left velocity sign
-#define SIGN_V_BR (-1.0f)    // back right velocity sign
+// omni x chassis, wheel mounting signs as seen by the motor velocity
+static const KineConfig chassis_geometry = {
+    .type = KINE_OMNI_X,
+    .wheel_radius = 0.10f, // m
+    .half_length = 0.20f,  // m, wheel centre to chassis centre along x
+    .half_width = 0.20f,   // m, along y
+    .sign = {-1.0f, 1.0f, 1.0f, -1.0f}, // front right, front left, back left, back right
+};
 
-static inline void linear_omni_motion(float32_t v_x, float32_t v_y)
+static KineInfo chassis_kine;
+static uint8_t chassis_kine_ready = 0;
+static uint8_t body_spinning = 0;
+
+// chassis frame velocity: vx, vy in m/s, wz in rad/s
+static inline void chassis_motion(float32_t v_x, float32_t v_y, float32_t w_z)
 {
-    float32_t v_chassis[2] = {v_x, v_y};
-    float32_t v_wheels[4];
-    kine_omni_decomposition(v_chassis, v_wheels);
-
-    set_body_velocity(
-        SIGN_V_FR * v_wheels[0] / WHEEL_RADIUS,
-        SIGN_V_FL * v_wheels[1] / WHEEL_RADIUS,
-        SIGN_V_BL * v_wheels[2] / WHEEL_RADIUS,
-        SIGN_V_BR * v_wheels[3] / WHEEL_RADIUS);
+    // matrices are built once, no init hook runs before the scheduler
+    if (!chassis_kine_ready)
+    {
+        kine_init(&chassis_kine, &chassis_geometry);
+        chassis_kine_ready = 1;
+
+        // wheel pattern of a pure spin, the power limit tells rotation from translation with it
+        float32_t spin[3] = {0.0f, 0.0f, 1.0f};
+        float32_t w_spin[KINE_WHEEL_NUM];
+        kine_inverse(&chassis_kine, spin, w_spin);
+        set_body_power_rotation(w_spin);
+    }
+
+    float32_t v_chassis[3] = {v_x, v_y, w_z};
+    float32_t w_wheels[KINE_WHEEL_NUM];
+    kine_inverse(&chassis_kine, v_chassis, w_wheels);
+
+    set_body_velocity(w_wheels[0], w_wheels[1], w_wheels[2], w_wheels[3]);
 }
 
 /*
@@ -39,21 +59,54 @@ static inline void linear_omni_motion(float32_t v_x, float32_t v_y)
  **************************************************************************
  */
 
-void safe_mode(void)
+void safe_mode(DbusData *rc)
 {
-    float32_t v_x = dbus_data.ls_x * VELOCITY_SCALE;
-    float32_t v_y = -dbus_data.ls_y * VELOCITY_SCALE;
+    float32_t v_x = rc->ls_x * VELOCITY_SCALE;
+    float32_t v_y = -rc->ls_y * VELOCITY_SCALE;
 
-    linear_omni_motion(v_x, v_y);
+    chassis_motion(v_x, v_y, 0.0f);
+}
+
+void spin_mode(DbusData *rc)
+{
+    MotorInfo yaw;
+    motor_get_info(GIMBAL_YAW, &yaw);
+
+    // the stick drives in the gimbal frame, turned by the yaw angle it will have half way through this period
+    // and once the wheels have followed, or the ground track trails the gimbal by the spin rate times the lag
+    float32_t v_gimbal[2] = {rc->ls_x * VELOCITY_SCALE, -rc->ls_y * VELOCITY_SCALE};
+    float32_t v_chassis[2];
+    float32_t lead = 0.5f * BODY_PERIOD + SPIN_DRIVE_LEAD;
+    kine_gimbal_follow(yaw.zero_offset + yaw.velocity_est * lead, v_gimbal, v_chassis);
+
+    chassis_motion(v_chassis[0], v_chassis[1], SPIN_RATE);
 }
 
 void body_task(void)
 {
-    if (dbus_data.sw1 == SW_UP) // turn down the infantry
+    DbusData rc;
+    dbus_get_data(&rc);
+
+    if (rc.sw1 == SW_UP) // turn down the infantry
     {
+        body_spinning = 0;
         motor_set_body_current(0.0f, 0.0f, 0.0f, 0.0f);
         return;
     }
 
-    safe_mode();
+    // sw2 down: spinning top, the gimbal holds its world heading in neck_task
+    body_spinning = (rc.sw2 == SW_DOWN);
+    if (body_spinning)
+    {
+        spin_mode(&rc);
+    }
+    else
+    {
+        safe_mode(&rc);
+    }
+}
+
+uint8_t body_is_spinning(void)
+{
+    return body_spinning;
 }
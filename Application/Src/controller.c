@@ -1,14 +1,12 @@
 #include "pid.h"
 #include "motor.h"
 #include "controller.h"
+#include "power_limit.h"
 
 #ifndef PI
 #define PI (3.14159265358979f)
 #endif
 
-#define M3508_REDUCTION_RATIO (19.0f)
-#define M2006_REDUCTION_RATIO (36.0f)
-
 /*
  **************************************************************************
  * parameters
@@ -50,6 +48,9 @@ PidInfo pid_br_v2c = {
     .out_limit = 20.0f, // current limit 20.0A
 };
 
+// chassis power budget after the wheel pids, rotation pattern set by body_task
+PowerLimit body_power = POWER_LIMIT_INIT(POWER_LIMIT_DEFAULT);
+
 PidInfo pid_pitch_v2v = {
     // gimbal pitch gm6020 velocity to voltage pid (motors[5])
     .kp = 1.3f,
@@ -131,26 +132,30 @@ static inline float val_limit_float(float x, float min, float max)
     return x;
 }
 
-static inline float optimal_measure(float target, float measure)
+// motor without feedback: zero its command and clear the pid state, it restarts clean when it comes back
+static inline float fail_safe(Motor_Index index, PidInfo *pid, float command)
 {
-    float raw_diff = target - measure;
-
-    if (raw_diff >= PI)
-    {
-        measure += 2 * PI;
-    }
-    else if (raw_diff <= -PI)
+    if (motor_is_online(index))
     {
-        measure -= 2 * PI;
+        return command;
     }
+    state_reset(pid);
+    return 0.0f;
+}
 
-    return measure;
+static inline float motor_velocity(Motor_Index index)
+{
+    MotorInfo info;
+    motor_get_info(index, &info);
+    return info.velocity;
 }
 
 static inline float gimbal_pitch_v2v_control(float target_vel, float measure_vel)
 {
     float command, linear_scale = 0;
-    int raw_angle = motors[GIMBAL_PITCH].raw_angle;
+    MotorInfo pitch;
+    motor_get_info(GIMBAL_PITCH, &pitch);
+    int raw_angle = pitch.raw_angle;
 
     // ugly linear mapping fucntion
     if (target_vel >= 0)
@@ -205,26 +210,51 @@ void set_body_velocity(float v_fr, float v_fl, float v_bl, float v_br)
     v_bl = v_bl * M3508_REDUCTION_RATIO;
     v_br = v_br * M3508_REDUCTION_RATIO;
 
+    float velocity[4] = {
+        motor_velocity(CHASSIS_FR),
+        motor_velocity(CHASSIS_FL),
+        motor_velocity(CHASSIS_BL),
+        motor_velocity(CHASSIS_BR),
+    };
+
     // calculate current command
-    float c_fr = pid_calculate(&pid_fr_v2c, v_fr, motors[CHASSIS_FR].velocity); // front right
-    float c_fl = pid_calculate(&pid_fl_v2c, v_fl, motors[CHASSIS_FL].velocity); // front left
-    float c_bl = pid_calculate(&pid_bl_v2c, v_bl, motors[CHASSIS_BL].velocity); // back left
-    float c_br = pid_calculate(&pid_br_v2c, v_br, motors[CHASSIS_BR].velocity); // back right
+    float current[4];
+    current[0] = pid_calculate(&pid_fr_v2c, v_fr, velocity[0]); // front right
+    current[1] = pid_calculate(&pid_fl_v2c, v_fl, velocity[1]); // front left
+    current[2] = pid_calculate(&pid_bl_v2c, v_bl, velocity[2]); // back left
+    current[3] = pid_calculate(&pid_br_v2c, v_br, velocity[3]); // back right
+    current[0] = fail_safe(CHASSIS_FR, &pid_fr_v2c, current[0]);
+    current[1] = fail_safe(CHASSIS_FL, &pid_fl_v2c, current[1]);
+    current[2] = fail_safe(CHASSIS_BL, &pid_bl_v2c, current[2]);
+    current[3] = fail_safe(CHASSIS_BR, &pid_br_v2c, current[3]);
+
+    // keep the estimated electrical power under the chassis cap
+    power_limit_apply(&body_power, current, velocity);
 
     // set current command
-    motor_set_body_current(c_fr, c_fl, c_bl, c_br);
+    motor_set_body_current(current[0], current[1], current[2], current[3]);
 }
 
-void set_neck_position(float pos_target, float pos_measure, float v_measure)
+void set_body_power_rotation(const float rotation[4])
+{
+    power_limit_set_rotation(&body_power, rotation);
+}
+
+void set_neck_position(float pos_target, float pos_measure, float v_measure, float w_chassis)
 {
     float command, command_vel;
 
-    pos_measure = optimal_measure(pos_target, pos_measure);
     command_vel = pid_calculate(&pid_yaw_p2v, pos_target, pos_measure);
 
-    // linear mapping and pid for velocity control
-    command = 0.8 * command_vel + pid_calculate(&pid_yaw_v2v, command_vel, v_measure);
+    // linear mapping of the motor speed the target asks for, the stator turns with the chassis,
+    // and pid for velocity control
+    command = 0.8 * (command_vel - w_chassis) + pid_calculate(&pid_yaw_v2v, command_vel, v_measure);
     command = val_limit_float(command, -24.0, 24.0); // voltage limit 24.0
+    command = fail_safe(GIMBAL_YAW, &pid_yaw_v2v, command);
+    if (!motor_is_online(GIMBAL_YAW))
+    {
+        state_reset(&pid_yaw_p2v);
+    }
 
     motor_set_neck_voltage(command);
 }
@@ -237,12 +267,22 @@ void set_head_command(float pos_pitch_target, float pos_pitch_measure,
     float command_pitch = gimbal_pitch_v2v_control(pitch_command_vel, vel_pitch_measure);
 
     // friction left and friction velocity to current control, without velocity reduction
-    float command_fric_l = pid_calculate(&pid_friction_l_v2c, v_fric_l, motors[FRICTION_L].velocity);
-    float command_fric_r = pid_calculate(&pid_friction_r_v2c, v_fric_r, motors[FRICTION_R].velocity);
+    float command_fric_l = pid_calculate(&pid_friction_l_v2c, v_fric_l, motor_velocity(FRICTION_L));
+    float command_fric_r = pid_calculate(&pid_friction_r_v2c, v_fric_r, motor_velocity(FRICTION_R));
 
     // trigger velocity to current control, without reduction
     v_trigger = M2006_REDUCTION_RATIO * v_trigger;
-    float command_trigger = pid_calculate(&pid_trigger_v2c, v_trigger, motors[TRIGGER].velocity);
+    float command_trigger = pid_calculate(&pid_trigger_v2c, v_trigger, motor_velocity(TRIGGER));
+
+    // stop the motors without feedback
+    command_pitch = fail_safe(GIMBAL_PITCH, &pid_pitch_v2v, command_pitch);
+    if (!motor_is_online(GIMBAL_PITCH))
+    {
+        state_reset(&pid_pitch_p2v);
+    }
+    command_fric_l = fail_safe(FRICTION_L, &pid_friction_l_v2c, command_fric_l);
+    command_fric_r = fail_safe(FRICTION_R, &pid_friction_r_v2c, command_fric_r);
+    command_trigger = fail_safe(TRIGGER, &pid_trigger_v2c, command_trigger);
 
     // set command
     motor_set_head_command(command_pitch, command_fric_l, command_fric_r, command_trigger);
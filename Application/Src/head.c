@@ -12,7 +12,6 @@
 #define V_TRIGGER (3.0f) // in rad
 
 #define PITCH_HALF_ANGLE ((2190.f - 670.0f) / 8192.0f / 2.0f * 2 * PI)
-#define GET_POSITION_FROM_ANGLE(angle) (((float)angle - 1430.0f) / 8192.0f * 2 * PI)
 #define FREQUENCY_HEAD (1000.0f)
 #define PITCH_SENSITIVITY (6.0f)
 
@@ -40,7 +39,11 @@ static inline void limit_pitch_target(float *pos_pitch_target)
  */
 void head_task(void)
 {
-    if (dbus_data.sw1 == SW_UP)
+    DbusData rc;
+    MotorInfo pitch;
+    dbus_get_data(&rc);
+
+    if (rc.sw1 == SW_UP)
     { // close the head
         motor_set_head_command(0.0f, 0.0f, 0.0f, 0.0f);
         return;
@@ -48,20 +51,21 @@ void head_task(void)
 
     // get pitch position target and position measure
     static float pos_pitch_target, pos_pitch_measure, vel_pitch_measure, v_fric_l, v_fric_r, v_trigger;
-    pos_pitch_target -= ((dbus_data.rs_x * PITCH_HALF_ANGLE / FREQUENCY_HEAD) * PITCH_SENSITIVITY);
+    pos_pitch_target -= ((rc.rs_x * PITCH_HALF_ANGLE / FREQUENCY_HEAD) * PITCH_SENSITIVITY);
     limit_pitch_target(&pos_pitch_target);
-    pos_pitch_measure = GET_POSITION_FROM_ANGLE(motors[GIMBAL_PITCH].raw_angle);
+    motor_get_info(GIMBAL_PITCH, &pitch);
+    pos_pitch_measure = pitch.output_angle; // 0 at raw_angle 1430
 
-    // get pitch velocity measure
-    vel_pitch_measure = motors[GIMBAL_PITCH].velocity;
+    // get pitch velocity measure, same feedback frame as the position, pll below 1 rpm
+    vel_pitch_measure = pitch.velocity_est;
 
-    if (dbus_data.wheel > 1024)
+    if (rc.wheel > 1024)
     {
         v_fric_l = V_FRICTION_L;
         v_fric_r = V_FRICTION_R;
         v_trigger = V_TRIGGER;
     }
-    else if (dbus_data.wheel < 1024)
+    else if (rc.wheel < 1024)
     {
         v_trigger = -V_TRIGGER;
     }
@@ -1,6 +1,8 @@
+#include <math.h>
 #include "pid.h"
 #include "motor.h"
 #include "neck.h"
+#include "body.h"
 #include "imu.h"
 #include "dbus.h"
 #include "controller.h"
@@ -9,39 +11,13 @@
 #define PI (3.14159265358979f)
 #endif
 
-#define RIGHT_FORWARD_ANGLE (3406.0f) // int, but transformed into float
-#define TOTAL_ANGLE_NUMBER (8192.0f)
-
 #define FREQUENCY 1000.0f
+#define WORLD_YAW_RATE (0.1f) // rad/s, chassis rate counted as turning
+#define WORLD_YAW_HOLD (400)  // ms, chassis still before a stopped spin hands back to the encoder
 
-static inline float get_yaw_pos_from_motor(void)
+static inline float wrap_pi(float x)
 {
-    float angle = (motors[GIMBAL_YAW].raw_angle - RIGHT_FORWARD_ANGLE) / TOTAL_ANGLE_NUMBER;
-    angle = angle * 2 * PI;
-
-    // make sure the angle is within - PI ~ PI
-    if (angle > PI)
-    {
-        angle -= 2 * PI;
-    }
-    else if (angle < -PI)
-    {
-        angle += 2 * PI;
-    }
-
-    return angle;
-}
-
-static inline void get_right_target(float *target)
-{
-    if (*target >= PI)
-    {
-        *target -= 2 * PI;
-    }
-    else if (*target <= -PI)
-    {
-        *target += 2 * PI;
-    }
+    return x - 2.0f * PI * floorf((x + PI) / (2.0f * PI));
 }
 
 /*
@@ -51,17 +27,66 @@ static inline void get_right_target(float *target)
  */
 void neck_task(void)
 {
-    static float pos_target = 0;
-    if (dbus_data.sw1 == SW_UP) // turn down the infantry
+    static float pos_target = 0;   // encoder frame, continuous through the slip ring
+    static float world_target = 0; // imu frame, within +-pi
+    static uint8_t world_mode = 0;
+    static uint32_t world_still = WORLD_YAW_HOLD; // ms the chassis has not been turning
+    DbusData rc;
+    MotorInfo yaw;
+    ImuData imu;
+    dbus_get_data(&rc);
+
+    if (rc.sw1 == SW_UP) // turn down the infantry
     {
         motor_set_neck_voltage(0.0f);
         return;
     }
 
-    pos_target += (-dbus_data.rs_y / FREQUENCY) * 2 * PI; // - rs_y
-    get_right_target(&pos_target);
-    float pos_measure = get_yaw_pos_from_motor();
-    float vel_measure = motors[GIMBAL_YAW].velocity;
+    // angle and velocity from the same feedback frame
+    motor_get_info(GIMBAL_YAW, &yaw);
+    imu_read_data(&imu);
 
-    set_neck_position(pos_target, pos_measure, vel_measure);
+    // 0 is forward and the first frame is within half a turn of it
+    float pos_measure = yaw.output_angle;
+    float vel_measure = yaw.velocity_est; // pll, the reported rpm steps by 0.1 rad/s
+
+    // the imu is on the chassis: gimbal heading = chassis yaw + yaw motor angle, same for the rates,
+    // the wrapped angle keeps its resolution however many turns the chassis has spun under the gimbal
+    float w_chassis = imu.velocity_yaw;
+    float world_measure = wrap_pi(imu.angle_yaw + yaw.zero_offset);
+
+    // hold the world heading while the chassis spins and until it has settled after the wind down,
+    // the pending error carries over both ways
+    if (body_is_spinning() || fabsf(w_chassis) > WORLD_YAW_RATE)
+    {
+        world_still = 0;
+    }
+    else if (world_still < WORLD_YAW_HOLD)
+    {
+        world_still++;
+    }
+    uint8_t world = imu_is_ready() && world_still < WORLD_YAW_HOLD;
+    if (world && !world_mode)
+    {
+        world_target = wrap_pi(world_measure + wrap_pi(pos_target - pos_measure));
+    }
+    else if (!world && world_mode)
+    {
+        pos_target = pos_measure + wrap_pi(world_target - world_measure);
+    }
+    world_mode = world;
+
+    float delta = (-rc.rs_y / FREQUENCY) * 2 * PI; // - rs_y
+    if (world_mode)
+    {
+        // measure unwrapped next to the target
+        world_target = wrap_pi(world_target + delta);
+        world_measure = world_target - wrap_pi(world_target - world_measure);
+        set_neck_position(world_target, world_measure, w_chassis + vel_measure, w_chassis);
+    }
+    else
+    {
+        pos_target += delta;
+        set_neck_position(pos_target, pos_measure, vel_measure, 0.0f);
+    }
 }
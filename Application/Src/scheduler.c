@@ -0,0 +1,130 @@
+#include "main.h"
+#include "scheduler.h"
+#include "bsp_tim.h"
+#include "bsp_dwt.h"
+#include "imu.h"
+#include "neck.h"
+#include "head.h"
+#include "body.h"
+#include "motor.h"
+
+/*
+ **************************************************************************
+ * global variables
+ **************************************************************************
+ */
+SchedStat sched_stat;
+
+static void imu_stage(void);
+
+// highest rate first, ties in the order the data flows
+static const SchedEntry sched_table[SCHED_TASK_NUM] = {
+    [SCHED_IMU] = {.task = imu_stage, .divider = 1, .offset = 0, .deadline = 100, .profile = PROFILE_IMU},
+    [SCHED_FILTER] = {.task = imu_filter_run, .divider = 1, .offset = 0, .deadline = 300, .profile = PROFILE_FILTER},
+    [SCHED_NECK] = {.task = neck_task, .divider = 1, .offset = 0, .deadline = 500, .profile = PROFILE_NECK},
+    [SCHED_HEAD] = {.task = head_task, .divider = 1, .offset = 0, .deadline = 700, .profile = PROFILE_HEAD},
+    [SCHED_BODY] = {.task = body_task, .divider = 8, .offset = 0, .deadline = 900, .profile = PROFILE_BODY}, // 125 Hz
+};
+
+static uint32_t tick_start;
+static volatile uint8_t control_due; // the control half of the current tick has not run yet
+
+/*
+ **************************************************************************
+ * helper functions
+ **************************************************************************
+ */
+static void run_entry(int i)
+{
+    const SchedEntry *entry = &sched_table[i];
+    if (sched_stat.tick % entry->divider != entry->offset)
+    {
+        return;
+    }
+
+    uint32_t start = profile_begin((ProfileTask)entry->profile);
+    entry->task();
+    profile_end((ProfileTask)entry->profile, start);
+
+    if (Get_Time_us() - tick_start > entry->deadline)
+    {
+        sched_stat.miss[i]++;
+    }
+}
+
+static void control_pend(void)
+{
+    SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+}
+
+static void imu_stage(void)
+{
+    imu_update();
+}
+
+/*
+ **************************************************************************
+ * exposed interfaces
+ **************************************************************************
+ */
+void scheduler_tick(void)
+{
+    uint32_t now = Get_Time_us();
+
+    // the burst of the previous tick never finished, its control half runs now on the last published sample
+    if (control_due)
+    {
+        sched_stat.imu_late++;
+        scheduler_control();
+    }
+
+    // a tick overrunning its period makes the next update interrupt late or coalesced
+    if (sched_stat.tick > 0 && now - tick_start > SCHED_TICK_US + SCHED_TICK_US / 2)
+    {
+        sched_stat.lost += (now - tick_start - SCHED_TICK_US / 2) / SCHED_TICK_US;
+    }
+    tick_start = now;
+
+    // the spi dma interrupt pends the control half once the burst of this tick is decoded
+    imu_set_done_callback(control_pend);
+    control_due = 1;
+    run_entry(SCHED_IMU);
+
+#if !IMU_USE_DATA_READY
+    if (!imu_sample_pending())
+#endif
+    {
+        // no burst in flight: sensor not ready yet, burst dropped, or the sensor paces sampling itself
+        control_pend();
+    }
+}
+
+void scheduler_control(void)
+{
+    // a decoded burst is filtered even when it finished late, after its tick already ran the control half,
+    // or came from a data ready edge between ticks
+    if (imu_filter_pending())
+    {
+        run_entry(SCHED_FILTER);
+    }
+    if (!control_due)
+    {
+        return;
+    }
+    control_due = 0;
+
+    for (int i = SCHED_FILTER + 1; i < SCHED_TASK_NUM; i++)
+    {
+        run_entry(i);
+    }
+
+    // every command of this tick leaves together
+    motor_flush_commands();
+
+    uint32_t latency = Get_Time_us() - tick_start;
+    if (latency > sched_stat.latency_max)
+    {
+        sched_stat.latency_max = latency;
+    }
+    sched_stat.tick++;
+}
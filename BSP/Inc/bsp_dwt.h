@@ -0,0 +1,66 @@
+#ifndef __BSP_DWT_H__
+#define __BSP_DWT_H__
+
+#include <stdint.h>
+
+/*
+ * per-task execution profiler on the DWT cycle counter
+ * profile_table lives in RAM, dump it with the debugger and decode it with build_host/profile_decode:
+ *   (gdb) dump binary value profile.bin profile_table
+ */
+
+#define PROFILE_MAGIC (0x50524F46) // "PROF"
+#define PROFILE_VERSION (2)
+#define PROFILE_HIST_BINS (32) // bin k counts executions of 2^k ~ 2^(k+1)-1 cycles
+
+typedef enum
+{
+    PROFILE_IMU = 0, // imu_update, starts the spi dma burst, scheduler tick
+    PROFILE_FILTER,  // imu_filter_run, calibration, gyro_cal and attitude filter of the burst, PendSV
+    PROFILE_NECK,    // neck_task, scheduler tick
+    PROFILE_HEAD,    // head_task, scheduler tick
+    PROFILE_BODY,    // body_task, every 8th scheduler tick
+
+    PROFILE_TASK_NUM
+} ProfileTask;
+
+#define PROFILE_TASK_NAMES {"imu", "filter", "neck", "head", "body"}
+
+typedef struct
+{
+    // execution time, in cycles
+    uint32_t count;
+    uint32_t exec_min;
+    uint32_t exec_max;
+    uint64_t exec_sum;
+
+    // time between successive starts, in cycles
+    uint32_t last_start;
+    uint32_t period_min;
+    uint32_t period_max;
+    uint64_t period_sum;
+
+    uint32_t hist[PROFILE_HIST_BINS]; // log2 histogram of execution cycles
+} TaskProfile;
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t core_clock; // Hz, cycles to time
+    uint32_t task_num;
+    TaskProfile task[PROFILE_TASK_NUM];
+} ProfileTable;
+
+void BSP_DWT_Init(void);
+uint32_t BSP_DWT_Cycles(void);
+
+// wrap a task: uint32_t start = profile_begin(PROFILE_NECK); neck_task(); profile_end(PROFILE_NECK, start);
+uint32_t profile_begin(ProfileTask task);
+void profile_end(ProfileTask task, uint32_t start);
+void profile_reset(void);
+
+// global variables
+extern ProfileTable profile_table;
+
+#endif // __BSP_DWT_H__
@@ -5,5 +5,6 @@
 
 void BSP_FDCAN_Init(void);
 HAL_StatusTypeDef BSP_FDCAN_TxMessage(FDCAN_HandleTypeDef *hfdcan, uint32_t StdId, uint8_t *pData);
+void BSP_FDCAN_IRQHandler(FDCAN_HandleTypeDef *hfdcan); // rx fifo new message, replaces HAL_FDCAN_IRQHandler
 
 #endif // __BSP_FDCAN_H__
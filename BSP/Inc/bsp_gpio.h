@@ -9,6 +9,12 @@
 #define SET_CS_GYRO_LOW() HAL_GPIO_WritePin(CS_GYRO_GPIO_Port, CS_GYRO_Pin, GPIO_PIN_RESET)
 #define SET_CS_GYRO_HIGH() HAL_GPIO_WritePin(CS_GYRO_GPIO_Port, CS_GYRO_Pin, GPIO_PIN_SET)
 
+// bmi088 data ready lines on the dm-mc02: accel INT1 -> PE10, gyro INT3 -> PE12
+#define INT_ACCEL_Pin GPIO_PIN_10
+#define INT_ACCEL_GPIO_Port GPIOE
+#define INT_GYRO_Pin GPIO_PIN_12
+#define INT_GYRO_GPIO_Port GPIOE
+
 void BSP_GPIO_Init(void);
 
 #endif // __BSP_GPIO_H__
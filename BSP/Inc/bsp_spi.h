@@ -2,8 +2,15 @@
 #define __BSP_SPI_H__
 
 #include <stdint.h>
+#include "spi.h"
+
+// called from the spi2 interrupt when a dma transfer ends, status is HAL_OK or HAL_ERROR
+typedef void (*SPI_DMA_Callback)(HAL_StatusTypeDef status);
 
 void BSP_SPI_Init(void);
 uint8_t SPI2_Transfer_Byte(uint8_t Tx_Data);
 
-#endif // __BSP_SPI_H__
\ No newline at end of file
+// asynchronous full duplex transfer, buffers must be dma reachable (.dma12_buffer)
+HAL_StatusTypeDef SPI2_Transfer_DMA(uint8_t *tx_buf, uint8_t *rx_buf, uint16_t len, SPI_DMA_Callback callback);
+
+#endif // __BSP_SPI_H__
@@ -3,8 +3,12 @@
 
 #include <stdint.h>
 
+#define TIM_TICK_PRIORITY (1) // nvic preempt priority of the TIM4 scheduler tick, ingest interrupts stay at 0
+
 void BSP_TIM_Init(void);
 void Delay_us(uint16_t us);
-void Delay_ms(uint16_t ms);
+void Delay_ms(uint32_t ms); // up to ~71 min, the TIM2 wrap
+uint32_t Get_Time_us(void); // free running TIM2, 1us per count, wraps every ~71 min
+void Heater_Set_Duty(float duty); // imu heater pwm, TIM3 channel 4, 0 ~ 1
 
 #endif // __BSP_TIM_H__
\ No newline at end of file
@@ -0,0 +1,95 @@
+#include "bsp_dwt.h"
+#include <string.h>
+#include "main.h"
+
+/*
+ **************************************************************************
+ * global variables
+ **************************************************************************
+ */
+ProfileTable profile_table;
+
+/*
+ **************************************************************************
+ * cycle counter
+ **************************************************************************
+ */
+void BSP_DWT_Init(void)
+{
+    // enable trace, unlock the dwt (required on cortex-m7) and start the counter
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->LAR = 0xC5ACCE55;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    profile_reset();
+}
+
+uint32_t BSP_DWT_Cycles(void)
+{
+    return DWT->CYCCNT;
+}
+
+/*
+ **************************************************************************
+ * task profiler
+ **************************************************************************
+ */
+void profile_reset(void)
+{
+    memset(&profile_table, 0, sizeof(profile_table));
+    profile_table.magic = PROFILE_MAGIC;
+    profile_table.version = PROFILE_VERSION;
+    profile_table.core_clock = SystemCoreClock;
+    profile_table.task_num = PROFILE_TASK_NUM;
+
+    for (int i = 0; i < PROFILE_TASK_NUM; i++)
+    {
+        profile_table.task[i].exec_min = UINT32_MAX;
+        profile_table.task[i].period_min = UINT32_MAX;
+    }
+}
+
+uint32_t profile_begin(ProfileTask task)
+{
+    uint32_t start = DWT->CYCCNT;
+    TaskProfile *profile = &profile_table.task[task];
+
+    // period between successive starts, wraps every ~8 s, fine for unsigned subtraction
+    if (profile->count > 0)
+    {
+        uint32_t period = start - profile->last_start;
+        if (period < profile->period_min)
+        {
+            profile->period_min = period;
+        }
+        if (period > profile->period_max)
+        {
+            profile->period_max = period;
+        }
+        profile->period_sum += period;
+    }
+    profile->last_start = start;
+
+    return start;
+}
+
+void profile_end(ProfileTask task, uint32_t start)
+{
+    uint32_t cycles = DWT->CYCCNT - start;
+    TaskProfile *profile = &profile_table.task[task];
+
+    if (cycles < profile->exec_min)
+    {
+        profile->exec_min = cycles;
+    }
+    if (cycles > profile->exec_max)
+    {
+        profile->exec_max = cycles;
+    }
+    profile->exec_sum += cycles;
+    profile->count++;
+
+    // log2 bin, clz is a single instruction on the m7
+    profile->hist[cycles ? 31 - __builtin_clz(cycles) : 0]++;
+}
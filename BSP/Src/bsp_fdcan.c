@@ -3,24 +3,111 @@
 #include "bsp_fdcan.h"
 #include "stm32h7xx_hal.h"
 
-FDCAN_RxHeaderTypeDef RxHeader;
-uint8_t RxData[8];
-
-// initialize FDCAN peripheral
-void FDCAN1_Init()
+#define FDCAN_RX_ID_BASE (0x201)     // first esc feedback id
+#define FDCAN_RX_ID_NUM (9)          // 0x201 ~ 0x209
+#define FDCAN_RX_ELEMENT_SIZE (16)   // bytes, 2 header words + 8 data bytes
+#define FDCAN_RX_ID(r0) (((r0) >> 18) & 0x7FF) // standard id in the first header word
+
+// standard filter elements cubemx reserves, StdFiltersNbr in Core/Src/fdcan.c and infantry.ioc
+#define FDCAN1_STD_FILTERS (3)
+#define FDCAN3_STD_FILTERS (2)
+
+// bus, id - FDCAN_RX_ID_BASE to motor slot, generated from motor_topology.h
+// an id outside 0x201 ~ 0x209 fails the build
+#define FDCAN_RX_MAP_ENTRY(index, type, bus, rx_id, frame, slot, reduction, zero)                                  \
+    [bus][(rx_id) - FDCAN_RX_ID_BASE] = &motors[index],
+static MotorInfo *const fdcan_motor_map[MOTOR_BUS_NUM][FDCAN_RX_ID_NUM] = {MOTOR_TOPOLOGY(FDCAN_RX_MAP_ENTRY)};
+
+// a repeated (bus, id) would silently take over the map entry: one bit per pair, the sum equals the or only when
+// no two rows share one
+#define FDCAN_RX_BIT(index, type, bus, rx_id, frame, slot, reduction, zero)                                        \
+    (1ULL << ((bus) * FDCAN_RX_ID_NUM + (rx_id) - FDCAN_RX_ID_BASE))
+#define FDCAN_RX_SUM(...) +FDCAN_RX_BIT(__VA_ARGS__)
+#define FDCAN_RX_OR(...) | FDCAN_RX_BIT(__VA_ARGS__)
+_Static_assert(MOTOR_BUS_NUM * FDCAN_RX_ID_NUM <= 64, "feedback ids do not fit the uniqueness mask");
+_Static_assert((0 MOTOR_TOPOLOGY(FDCAN_RX_SUM)) == (0 MOTOR_TOPOLOGY(FDCAN_RX_OR)),
+               "two motors share a feedback id on one bus");
+
+// ids per bus against the reserved filter elements, two ids per dual filter
+#define FDCAN_RX_ON_CAN1(index, type, bus, rx_id, frame, slot, reduction, zero) +((bus) == MOTOR_CAN1)
+#define FDCAN_RX_ON_CAN3(index, type, bus, rx_id, frame, slot, reduction, zero) +((bus) == MOTOR_CAN3)
+_Static_assert(((0 MOTOR_TOPOLOGY(FDCAN_RX_ON_CAN1)) + 1) / 2 <= FDCAN1_STD_FILTERS,
+               "more can1 feedback ids than filter elements");
+_Static_assert(((0 MOTOR_TOPOLOGY(FDCAN_RX_ON_CAN3)) + 1) / 2 <= FDCAN3_STD_FILTERS,
+               "more can3 feedback ids than filter elements");
+
+/*
+ **************************************************************************
+ * helper functions
+ **************************************************************************
+ */
+// hardware filter list from the dispatch map of the bus, two ids per dual filter element
+static void FDCAN_ConfigFilterList(FDCAN_HandleTypeDef *hfdcan, MotorInfo *const *motor_map, uint32_t fifo)
 {
-    // confitgure can filter
-    FDCAN_FilterTypeDef FDCAN1_FilterConfig;
-    FDCAN1_FilterConfig.IdType = FDCAN_STANDARD_ID;
-    FDCAN1_FilterConfig.FilterIndex = 0;
-    FDCAN1_FilterConfig.FilterType = FDCAN_FILTER_MASK;
-    FDCAN1_FilterConfig.FilterConfig = FDCAN_FILTER_TO_RXFIFO0;
-    FDCAN1_FilterConfig.FilterID1 = 0x00000000;
-    FDCAN1_FilterConfig.FilterID2 = 0x00000000;
-    if (HAL_FDCAN_ConfigFilter(&hfdcan1, &FDCAN1_FilterConfig) != HAL_OK)
+    uint16_t ids[FDCAN_RX_ID_NUM];
+    uint32_t num = 0;
+    for (uint32_t i = 0; i < FDCAN_RX_ID_NUM; i++)
+    {
+        if (motor_map[i] != NULL)
+        {
+            ids[num++] = FDCAN_RX_ID_BASE + i;
+        }
+    }
+
+    // more ids than cubemx reserved filter elements for
+    if ((num + 1) / 2 > hfdcan->Init.StdFiltersNbr)
     {
         Error_Handler();
     }
+
+    FDCAN_FilterTypeDef FilterConfig;
+    FilterConfig.IdType = FDCAN_STANDARD_ID;
+    FilterConfig.FilterType = FDCAN_FILTER_DUAL;
+    FilterConfig.FilterConfig = fifo;
+    for (uint32_t i = 0; i < num; i += 2)
+    {
+        FilterConfig.FilterIndex = i / 2;
+        FilterConfig.FilterID1 = ids[i];
+        FilterConfig.FilterID2 = ids[(i + 1 < num) ? i + 1 : i]; // odd count, last id twice
+        if (HAL_FDCAN_ConfigFilter(hfdcan, &FilterConfig) != HAL_OK)
+        {
+            Error_Handler();
+        }
+    }
+}
+
+// rx fifo 0 and 1 status / acknowledge registers share the same layout
+static void FDCAN_RxFifo_Drain(volatile uint32_t *status, volatile uint32_t *ack, uint32_t start_address,
+                               MotorInfo *const *motor_map)
+{
+    while ((*status & FDCAN_RXF0S_F0FL) != 0)
+    {
+        uint32_t get_index = (*status & FDCAN_RXF0S_F0GI) >> FDCAN_RXF0S_F0GI_Pos;
+        volatile uint32_t *element = (volatile uint32_t *)(start_address + get_index * FDCAN_RX_ELEMENT_SIZE);
+
+        // the filter list only passes known ids, the bound check guards the table anyway
+        uint32_t index = FDCAN_RX_ID(element[0]) - FDCAN_RX_ID_BASE;
+        if (index < FDCAN_RX_ID_NUM && motor_map[index] != NULL)
+        {
+            motor_data_interpret((uint8_t *)&element[2], motor_map[index]);
+        }
+
+        // release the element
+        *ack = get_index;
+    }
+}
+
+/*
+ **************************************************************************
+ * init and tx
+ **************************************************************************
+ */
+
+// initialize FDCAN peripheral
+void FDCAN1_Init()
+{
+    // configure can filter, only the esc feedback ids pass
+    FDCAN_ConfigFilterList(&hfdcan1, fdcan_motor_map[MOTOR_CAN1], FDCAN_FILTER_TO_RXFIFO0);
     if (HAL_FDCAN_ConfigGlobalFilter(&hfdcan1,
                                      FDCAN_REJECT, FDCAN_REJECT, FDCAN_FILTER_REMOTE, FDCAN_FILTER_REMOTE) != HAL_OK)
     {
@@ -42,18 +129,8 @@ void FDCAN1_Init()
 
 void FDCAN3_Init()
 {
-    // confitgure can filter
-    FDCAN_FilterTypeDef FDCAN3_FilterConfig;
-    FDCAN3_FilterConfig.IdType = FDCAN_STANDARD_ID;
-    FDCAN3_FilterConfig.FilterIndex = 0;
-    FDCAN3_FilterConfig.FilterType = FDCAN_FILTER_MASK;
-    FDCAN3_FilterConfig.FilterConfig = FDCAN_FILTER_TO_RXFIFO1;
-    FDCAN3_FilterConfig.FilterID1 = 0x00000000;
-    FDCAN3_FilterConfig.FilterID2 = 0x00000000;
-    if (HAL_FDCAN_ConfigFilter(&hfdcan3, &FDCAN3_FilterConfig) != HAL_OK)
-    {
-        Error_Handler();
-    }
+    // configure can filter, only the esc feedback ids pass
+    FDCAN_ConfigFilterList(&hfdcan3, fdcan_motor_map[MOTOR_CAN3], FDCAN_FILTER_TO_RXFIFO1);
     if (HAL_FDCAN_ConfigGlobalFilter(&hfdcan3,
                                      FDCAN_REJECT, FDCAN_REJECT, FDCAN_FILTER_REMOTE, FDCAN_FILTER_REMOTE) != HAL_OK)
     {
@@ -79,86 +156,45 @@ void BSP_FDCAN_Init(void)
     FDCAN3_Init();
 }
 
-// FDCAN Transmit Function
+// pre-built header, only the identifier changes between frames
+static FDCAN_TxHeaderTypeDef TxHeader = {
+    .IdType = FDCAN_STANDARD_ID,
+    .TxFrameType = FDCAN_DATA_FRAME,
+    .DataLength = FDCAN_DLC_BYTES_8, // dji-can always use 8 bytes
+    .ErrorStateIndicator = FDCAN_ESI_ACTIVE,
+    .BitRateSwitch = FDCAN_BRS_OFF, // standard can
+    .FDFormat = FDCAN_CLASSIC_CAN,
+    .TxEventFifoControl = FDCAN_NO_TX_EVENTS,
+    .MessageMarker = 0,
+};
+
+// FDCAN Transmit Function, called only from motor_flush_commands
+// returns HAL_ERROR when the tx fifo is full
 HAL_StatusTypeDef BSP_FDCAN_TxMessage(FDCAN_HandleTypeDef *hfdcan, uint32_t StdId, uint8_t *pData)
 {
-    FDCAN_TxHeaderTypeDef TxHeader;
-
-    // configure TxHeader
-    TxHeader.Identifier = StdId;
-    TxHeader.IdType = FDCAN_STANDARD_ID;
-    TxHeader.TxFrameType = FDCAN_DATA_FRAME;
-    TxHeader.DataLength = FDCAN_DLC_BYTES_8; // dji-can always use 8 bytes
-    TxHeader.ErrorStateIndicator = FDCAN_ESI_ACTIVE;
-    TxHeader.BitRateSwitch = FDCAN_BRS_OFF; // standard can
-    TxHeader.FDFormat = FDCAN_CLASSIC_CAN;
-    TxHeader.TxEventFifoControl = FDCAN_NO_TX_EVENTS;
-    TxHeader.MessageMarker = 0;
-
     // transmit can message
+    TxHeader.Identifier = StdId;
     return HAL_FDCAN_AddMessageToTxFifoQ(hfdcan, &TxHeader, pData);
 }
 
-FDCAN_RxHeaderTypeDef RxHeader1; // for can 1
-FDCAN_RxHeaderTypeDef RxHeader3; // for can 3
-uint8_t RxData1[8];
-uint8_t RxData3[8];
-
-void HAL_FDCAN_RxFifo0Callback(FDCAN_HandleTypeDef *hfdcan, uint32_t RxFifo0ITs)
+/*
+ **************************************************************************
+ * rx path: register level read of the rx fifo, straight into the motor slot
+ **************************************************************************
+ */
+void BSP_FDCAN_IRQHandler(FDCAN_HandleTypeDef *hfdcan)
 {
-    // receive message
-    if (HAL_FDCAN_GetRxMessage(hfdcan, FDCAN_RX_FIFO0, &RxHeader1, RxData1) != HAL_OK)
-    {
-        return;
-    }
+    FDCAN_GlobalTypeDef *can = hfdcan->Instance;
 
-    // interpret message
-    switch (RxHeader1.Identifier)
-    {
-    case 0x201: // chassis front right motor
-        motor_data_interpret(RxData1, &motors[CHASSIS_FR]);
-        break;
-    case 0x202: // chassis front left motor
-        motor_data_interpret(RxData1, &motors[CHASSIS_FL]);
-        break;
-    case 0x203: // chassis back left motor
-        motor_data_interpret(RxData1, &motors[CHASSIS_BL]);
-        break;
-    case 0x204: // chassis back right motor
-        motor_data_interpret(RxData1, &motors[CHASSIS_BR]);
-        break;
-    case 0x209: // gimbal yaw motor
-        motor_data_interpret(RxData1, &motors[GIMBAL_YAW]);
-        break;
-    default:
-        break;
-    }
-}
+    // clear first, a frame arriving while draining raises the line again
+    can->IR = FDCAN_IR_RF0N | FDCAN_IR_RF1N;
 
-void HAL_FDCAN_RxFifo1Callback(FDCAN_HandleTypeDef *hfdcan, uint32_t RxFifo1ITs)
-{
-    // receive message
-    if (HAL_FDCAN_GetRxMessage(hfdcan, FDCAN_RX_FIFO1, &RxHeader3, RxData3) != HAL_OK)
+    if (hfdcan == &hfdcan1)
     {
-        return;
+        FDCAN_RxFifo_Drain(&can->RXF0S, &can->RXF0A, hfdcan->msgRam.RxFIFO0SA, fdcan_motor_map[MOTOR_CAN1]);
     }
-
-    // interpret message
-    switch (RxHeader3.Identifier)
+    else
     {
-    case 0x205: // gimbal pitch motor
-        motor_data_interpret(RxData3, &motors[GIMBAL_PITCH]);
-        break;
-    case 0x206: // friction left motor
-        motor_data_interpret(RxData3, &motors[FRICTION_L]);
-        break;
-    case 0x207: // friction right motor
-        motor_data_interpret(RxData3, &motors[FRICTION_R]);
-        break;
-    case 0x208: // trigger motor
-        motor_data_interpret(RxData3, &motors[TRIGGER]);
-        break;
-    default:
-        break;
+        FDCAN_RxFifo_Drain(&can->RXF1S, &can->RXF1A, hfdcan->msgRam.RxFIFO1SA, fdcan_motor_map[MOTOR_CAN3]);
     }
 }
@@ -1,6 +1,38 @@
 #include "bsp_gpio.h"
+#include "imu.h"
 
 void BSP_GPIO_Init(void) {
-    // empty function, reserved
+#if IMU_USE_DATA_READY
+    // bmi088 data ready lines, push-pull active high on the sensor side
+    GPIO_InitTypeDef GPIO_InitStruct = {0};
+    __HAL_RCC_GPIOE_CLK_ENABLE();
+    GPIO_InitStruct.Pin = INT_ACCEL_Pin | INT_GYRO_Pin;
+    GPIO_InitStruct.Mode = GPIO_MODE_IT_RISING;
+    GPIO_InitStruct.Pull = GPIO_PULLDOWN;
+    HAL_GPIO_Init(INT_ACCEL_GPIO_Port, &GPIO_InitStruct);
+
+    HAL_NVIC_SetPriority(EXTI15_10_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(EXTI15_10_IRQn);
+#endif
     return;
 }
+
+#if IMU_USE_DATA_READY
+void EXTI15_10_IRQHandler(void)
+{
+    HAL_GPIO_EXTI_IRQHandler(INT_ACCEL_Pin);
+    HAL_GPIO_EXTI_IRQHandler(INT_GYRO_Pin);
+}
+
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+{
+    if (GPIO_Pin == INT_GYRO_Pin)
+    {
+        imu_gyro_data_ready();
+    }
+    else if (GPIO_Pin == INT_ACCEL_Pin)
+    {
+        imu_accel_data_ready();
+    }
+}
+#endif
@@ -1,10 +1,48 @@
 #include "bsp_spi.h"
 #include "spi.h"
 
+// spi2 dma streams, DMA1_Stream0 is taken by uart5 rx
+DMA_HandleTypeDef hdma_spi2_rx;
+DMA_HandleTypeDef hdma_spi2_tx;
+
+static SPI_DMA_Callback spi2_callback;
+
+static void SPI2_DMA_Stream_Init(DMA_HandleTypeDef *hdma, DMA_Stream_TypeDef *stream,
+                                 uint32_t request, uint32_t direction)
+{
+    hdma->Instance = stream;
+    hdma->Init.Request = request;
+    hdma->Init.Direction = direction;
+    hdma->Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma->Init.MemInc = DMA_MINC_ENABLE;
+    hdma->Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    hdma->Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    hdma->Init.Mode = DMA_NORMAL;
+    hdma->Init.Priority = DMA_PRIORITY_HIGH;
+    hdma->Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+    if (HAL_DMA_Init(hdma) != HAL_OK)
+    {
+        Error_Handler();
+    }
+}
+
 // initialize spi
 void BSP_SPI_Init(void)
 {
-    return;  // reserved
+    // dma1 clock is enabled by MX_DMA_Init
+    SPI2_DMA_Stream_Init(&hdma_spi2_rx, DMA1_Stream1, DMA_REQUEST_SPI2_RX, DMA_PERIPH_TO_MEMORY);
+    SPI2_DMA_Stream_Init(&hdma_spi2_tx, DMA1_Stream2, DMA_REQUEST_SPI2_TX, DMA_MEMORY_TO_PERIPH);
+    __HAL_LINKDMA(&hspi2, hdmarx, hdma_spi2_rx);
+    __HAL_LINKDMA(&hspi2, hdmatx, hdma_spi2_tx);
+
+    // ingest priority with fdcan and dbus, above the tick and PendSV: the completion only decodes the burst and
+    // pends PendSV, the filter runs there at the tick priority
+    HAL_NVIC_SetPriority(DMA1_Stream1_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(DMA1_Stream1_IRQn);
+    HAL_NVIC_SetPriority(DMA1_Stream2_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(DMA1_Stream2_IRQn);
+    HAL_NVIC_SetPriority(SPI2_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(SPI2_IRQn);
 }
 
 // returns the spi receive data after transmiting the specified data
@@ -14,3 +52,46 @@ uint8_t SPI2_Transfer_Byte(uint8_t Tx_Data)
 	HAL_SPI_TransmitReceive(&hspi2, &Tx_Data, &Rx_Data, 1, 100);
     return Rx_Data;
 }
+
+// start a dma transfer, the callback runs from the spi2 end of transfer interrupt
+HAL_StatusTypeDef SPI2_Transfer_DMA(uint8_t *tx_buf, uint8_t *rx_buf, uint16_t len, SPI_DMA_Callback callback)
+{
+    spi2_callback = callback;
+    return HAL_SPI_TransmitReceive_DMA(&hspi2, tx_buf, rx_buf, len);
+}
+
+/*
+ **************************************************************************
+ * spi2 dma interrupts and callbacks
+ **************************************************************************
+ */
+void DMA1_Stream1_IRQHandler(void)
+{
+    HAL_DMA_IRQHandler(&hdma_spi2_rx);
+}
+
+void DMA1_Stream2_IRQHandler(void)
+{
+    HAL_DMA_IRQHandler(&hdma_spi2_tx);
+}
+
+void SPI2_IRQHandler(void)
+{
+    HAL_SPI_IRQHandler(&hspi2);
+}
+
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspi)
+{
+    if (hspi == &hspi2 && spi2_callback != NULL)
+    {
+        spi2_callback(HAL_OK);
+    }
+}
+
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi)
+{
+    if (hspi == &hspi2 && spi2_callback != NULL)
+    {
+        spi2_callback(HAL_ERROR);
+    }
+}
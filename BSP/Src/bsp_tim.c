@@ -3,12 +3,18 @@
 
 void BSP_TIM_Init(void)
 {
-    // enable tim2, tim4, tim5, tim12, tim15
-    HAL_TIM_Base_Start(&htim2);     // accurate 1us and 1ms
-    HAL_TIM_Base_Start_IT(&htim4);  // imu update, 1000hz
-    HAL_TIM_Base_Start_IT(&htim5);  // neck control, 1000hz
-    HAL_TIM_Base_Start_IT(&htim12); // head control, 1000hz
-    HAL_TIM_Base_Start_IT(&htim15); // chassis control, 125hz      Instance = TIM15
+    // tim4 drives the scheduler tick, below the can / dbus / spi ingest interrupts,
+    // pendsv runs its control half at the same priority so neither preempts the other
+    HAL_NVIC_SetPriority(TIM4_IRQn, TIM_TICK_PRIORITY, 0);
+    HAL_NVIC_SetPriority(PendSV_IRQn, TIM_TICK_PRIORITY, 0);
+
+    // enable tim2, tim3, tim4; tim5, tim12 and tim15 are left free
+    HAL_TIM_Base_Start(&htim2);    // accurate 1us and 1ms
+    HAL_TIM_Base_Start_IT(&htim4); // scheduler tick, 1000hz
+
+    // imu heater off until the imu runs its controller
+    __HAL_TIM_SET_COMPARE(&htim3, TIM_CHANNEL_4, 0);
+    HAL_TIM_PWM_Start(&htim3, TIM_CHANNEL_4); // 1khz
 }
 
 void Delay_us(uint16_t us)
@@ -21,12 +27,33 @@ void Delay_us(uint16_t us)
     return;
 }
 
-void Delay_ms(uint16_t ms)
+void Delay_ms(uint32_t ms)
 {
+    // unsigned product, the old uint16_t argument was promoted to a signed int multiply
     uint32_t start = __HAL_TIM_GET_COUNTER(&htim2);
-    while ((__HAL_TIM_GET_COUNTER(&htim2) - start) < (ms * 1000))
+    uint32_t wait = ms * 1000U;
+    while ((__HAL_TIM_GET_COUNTER(&htim2) - start) < wait)
     {
         ;
     }
     return;
 }
+
+uint32_t Get_Time_us(void)
+{
+    return __HAL_TIM_GET_COUNTER(&htim2);
+}
+
+void Heater_Set_Duty(float duty)
+{
+    if (duty < 0.0f)
+    {
+        duty = 0.0f;
+    }
+    else if (duty > 1.0f)
+    {
+        duty = 1.0f;
+    }
+    uint32_t period = __HAL_TIM_GET_AUTORELOAD(&htim3) + 1;
+    __HAL_TIM_SET_COMPARE(&htim3, TIM_CHANNEL_4, (uint32_t)(duty * period));
+}
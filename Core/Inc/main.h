@@ -61,6 +61,8 @@ void Error_Handler(void);
 #define CS_ACCEL_GPIO_Port GPIOC
 #define CS_GYRO_Pin GPIO_PIN_3
 #define CS_GYRO_GPIO_Port GPIOC
+#define IMU_HEAT_Pin GPIO_PIN_1
+#define IMU_HEAT_GPIO_Port GPIOB
 
 /* USER CODE BEGIN Private defines */
 
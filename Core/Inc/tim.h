@@ -34,6 +34,8 @@ extern "C" {
 
 extern TIM_HandleTypeDef htim2;
 
+extern TIM_HandleTypeDef htim3;
+
 extern TIM_HandleTypeDef htim4;
 
 extern TIM_HandleTypeDef htim5;
@@ -47,11 +49,14 @@ extern TIM_HandleTypeDef htim15;
 /* USER CODE END Private defines */
 
 void MX_TIM2_Init(void);
+void MX_TIM3_Init(void);
 void MX_TIM4_Init(void);
 void MX_TIM5_Init(void);
 void MX_TIM12_Init(void);
 void MX_TIM15_Init(void);
 
+void HAL_TIM_MspPostInit(TIM_HandleTypeDef *htim);
+
 /* USER CODE BEGIN Prototypes */
 
 /* USER CODE END Prototypes */
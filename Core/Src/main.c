@@ -32,6 +32,7 @@
 #include "bsp_spi.h"
 #include "bsp_tim.h"
 #include "bsp_gpio.h"
+#include "bsp_dwt.h"
 #include "imu.h"
 /* USER CODE END Includes */
 
@@ -102,10 +103,12 @@ int main(void)
   MX_FDCAN3_Init();
   MX_SPI2_Init();
   MX_TIM2_Init();
+  MX_TIM3_Init();
   /* USER CODE BEGIN 2 */
   BSP_USART_Init();
   BSP_FDCAN_Init();
   BSP_SPI_Init();
+  BSP_DWT_Init();
   BSP_TIM_Init();
   BSP_GPIO_Init();
   imu_init();
@@ -22,10 +22,8 @@
 #include "stm32h7xx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
-#include "imu.h"
-#include "head.h"
-#include "neck.h"
-#include "body.h"
+#include "scheduler.h"
+#include "bsp_fdcan.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -181,7 +179,7 @@ void DebugMon_Handler(void)
 void PendSV_Handler(void)
 {
   /* USER CODE BEGIN PendSV_IRQn 0 */
-
+  scheduler_control();
   /* USER CODE END PendSV_IRQn 0 */
   /* USER CODE BEGIN PendSV_IRQn 1 */
 
@@ -229,6 +227,9 @@ void DMA1_Stream0_IRQHandler(void)
 void FDCAN1_IT0_IRQHandler(void)
 {
   /* USER CODE BEGIN FDCAN1_IT0_IRQn 0 */
+  // only the rx fifo 0 interrupt is enabled, read it at register level
+  BSP_FDCAN_IRQHandler(&hfdcan1);
+  return;
 
   /* USER CODE END FDCAN1_IT0_IRQn 0 */
   HAL_FDCAN_IRQHandler(&hfdcan1);
@@ -247,7 +248,7 @@ void TIM4_IRQHandler(void)
   /* USER CODE END TIM4_IRQn 0 */
   HAL_TIM_IRQHandler(&htim4);
   /* USER CODE BEGIN TIM4_IRQn 1 */
-  imu_update();
+  scheduler_tick();
   /* USER CODE END TIM4_IRQn 1 */
 }
 
@@ -261,7 +262,6 @@ void TIM8_BRK_TIM12_IRQHandler(void)
   /* USER CODE END TIM8_BRK_TIM12_IRQn 0 */
   HAL_TIM_IRQHandler(&htim12);
   /* USER CODE BEGIN TIM8_BRK_TIM12_IRQn 1 */
-  head_task();
   /* USER CODE END TIM8_BRK_TIM12_IRQn 1 */
 }
 
@@ -275,7 +275,6 @@ void TIM5_IRQHandler(void)
   /* USER CODE END TIM5_IRQn 0 */
   HAL_TIM_IRQHandler(&htim5);
   /* USER CODE BEGIN TIM5_IRQn 1 */
-  neck_task();
   /* USER CODE END TIM5_IRQn 1 */
 }
 
@@ -303,7 +302,6 @@ void TIM15_IRQHandler(void)
   /* USER CODE END TIM15_IRQn 0 */
   HAL_TIM_IRQHandler(&htim15);
   /* USER CODE BEGIN TIM15_IRQn 1 */
-  body_task();
   /* USER CODE END TIM15_IRQn 1 */
 }
 
@@ -313,6 +311,9 @@ void TIM15_IRQHandler(void)
 void FDCAN3_IT0_IRQHandler(void)
 {
   /* USER CODE BEGIN FDCAN3_IT0_IRQn 0 */
+  // only the rx fifo 1 interrupt is enabled, read it at register level
+  BSP_FDCAN_IRQHandler(&hfdcan3);
+  return;
 
   /* USER CODE END FDCAN3_IT0_IRQn 0 */
   HAL_FDCAN_IRQHandler(&hfdcan3);
@@ -35,6 +35,21 @@
 #define BMI088_TEMP_M 0x22
 #define BMI088_TEMP_L 0x23
 
+// accel fifo, 1024 bytes, header mode frames
+#define BMI088_ACC_FIFO_LENGTH_0 0x24
+#define BMI088_ACC_FIFO_LENGTH_1 0x25 // bits 5:0, byte count
+#define BMI088_ACC_FIFO_DATA 0x26     // burst reads do not increment the address
+#define BMI088_ACC_FIFO_DEPTH 1024
+
+// frame headers, the two low bits carry interrupt tags
+#define BMI088_ACC_FIFO_HEADER_MASK 0xFC
+#define BMI088_ACC_FIFO_HEADER_ACC 0x84    // followed by x/y/z, 6 bytes
+#define BMI088_ACC_FIFO_HEADER_SKIP 0x40   // followed by the skipped frame count, 1 byte
+#define BMI088_ACC_FIFO_HEADER_TIME 0x44   // followed by the sensor time, 3 bytes
+#define BMI088_ACC_FIFO_HEADER_CONFIG 0x48 // followed by 1 byte
+#define BMI088_ACC_FIFO_HEADER_DROP 0x50   // followed by 1 byte
+#define BMI088_ACC_FIFO_HEADER_EMPTY 0x80  // read past the last frame
+
 #define BMI088_ACC_CONF 0x40
 #define BMI088_ACC_CONF_MUST_Set 0x80
 #define BMI088_ACC_BWP_SHFITS 0x4
@@ -60,6 +75,26 @@
 #define BMI088_ACC_RANGE_12G (0x2 << BMI088_ACC_RANGE_SHFITS)
 #define BMI088_ACC_RANGE_24G (0x3 << BMI088_ACC_RANGE_SHFITS)
 
+#define BMI088_ACC_FIFO_DOWNS 0x45
+#define BMI088_ACC_FIFO_DOWNS_MUST_Set 0x80
+#define BMI088_ACC_FIFO_DOWNS_SHFITS 0x4 // fifo rate = odr / 2^downs
+
+#define BMI088_ACC_FIFO_WTM_0 0x46
+#define BMI088_ACC_FIFO_WTM_1 0x47 // bits 4:0, watermark in bytes
+
+#define BMI088_ACC_FIFO_CONFIG_0 0x48
+#define BMI088_ACC_FIFO_MODE_STREAM 0x02 // overwrite the oldest frames when full
+#define BMI088_ACC_FIFO_MODE_FIFO 0x03   // stop when full
+
+#define BMI088_ACC_FIFO_CONFIG_1 0x49
+#define BMI088_ACC_FIFO_CONFIG_1_MUST_Set 0x10
+#define BMI088_ACC_FIFO_ACC_EN_SHFITS 0x6
+#define BMI088_ACC_FIFO_ACC_EN (0x1 << BMI088_ACC_FIFO_ACC_EN_SHFITS)
+#define BMI088_ACC_FIFO_INT1_EN_SHFITS 0x3
+#define BMI088_ACC_FIFO_INT1_EN (0x1 << BMI088_ACC_FIFO_INT1_EN_SHFITS)
+#define BMI088_ACC_FIFO_INT2_EN_SHFITS 0x2
+#define BMI088_ACC_FIFO_INT2_EN (0x1 << BMI088_ACC_FIFO_INT2_EN_SHFITS)
+
 #define BMI088_INT1_IO_CTRL 0x53
 #define BMI088_ACC_INT1_IO_ENABLE_SHFITS 0x3
 #define BMI088_ACC_INT1_IO_ENABLE (0x1 << BMI088_ACC_INT1_IO_ENABLE_SHFITS)
@@ -85,6 +120,10 @@
 #define BMI088_ACC_INT2_DRDY_INTERRUPT (0x1 << BMI088_ACC_INT2_DRDY_INTERRUPT_SHFITS)
 #define BMI088_ACC_INT1_DRDY_INTERRUPT_SHFITS 0x2
 #define BMI088_ACC_INT1_DRDY_INTERRUPT (0x1 << BMI088_ACC_INT1_DRDY_INTERRUPT_SHFITS)
+#define BMI088_ACC_INT2_FWM_INTERRUPT (0x1 << 0x5)
+#define BMI088_ACC_INT2_FFULL_INTERRUPT (0x1 << 0x4)
+#define BMI088_ACC_INT1_FWM_INTERRUPT (0x1 << 0x1)
+#define BMI088_ACC_INT1_FFULL_INTERRUPT (0x1 << 0x0)
 
 #define BMI088_ACC_SELF_TEST 0x6D
 #define BMI088_ACC_SELF_TEST_OFF 0x00
@@ -116,6 +155,13 @@
 #define BMI088_GYRO_DYDR_SHFITS 0x7
 #define BMI088_GYRO_DYDR (0x1 << BMI088_GYRO_DYDR_SHFITS)
 
+// gyro fifo, 100 frames of x/y/z, no headers
+#define BMI088_GYRO_FIFO_STATUS 0x0E
+#define BMI088_GYRO_FIFO_OVERRUN_SHFITS 0x7
+#define BMI088_GYRO_FIFO_OVERRUN (0x1 << BMI088_GYRO_FIFO_OVERRUN_SHFITS)
+#define BMI088_GYRO_FIFO_FRAME_COUNT_MASK 0x7F
+#define BMI088_GYRO_FIFO_DEPTH 100
+
 #define BMI088_GYRO_RANGE 0x0F
 #define BMI088_GYRO_RANGE_SHFITS 0x0
 #define BMI088_GYRO_2000 (0x0 << BMI088_GYRO_RANGE_SHFITS)
@@ -169,6 +215,12 @@
 #define BMI088_GYRO_DRDY_IO_INT4 0x80
 #define BMI088_GYRO_DRDY_IO_BOTH (BMI088_GYRO_DRDY_IO_INT3 | BMI088_GYRO_DRDY_IO_INT4)
 
+#define BMI088_GYRO_FIFO_WM_EN 0x1E
+#define BMI088_GYRO_FIFO_WM_DISABLE 0x08
+#define BMI088_GYRO_FIFO_WM_ENABLE 0x88
+
+#define BMI088_GYRO_FIFO_EXT_INT_S 0x34
+
 #define BMI088_GYRO_SELF_TEST 0x3C
 #define BMI088_GYRO_RATE_OK_SHFITS 0x4
 #define BMI088_GYRO_RATE_OK (0x1 << BMI088_GYRO_RATE_OK_SHFITS)
@@ -179,5 +231,14 @@
 #define BMI088_GYRO_TRIG_BIST_SHFITS 0x0
 #define BMI088_GYRO_TRIG_BIST (0x1 << BMI088_GYRO_TRIG_BIST_SHFITS)
 
+#define BMI088_GYRO_FIFO_CONFIG_0 0x3D // bits 6:0, watermark in frames
+
+#define BMI088_GYRO_FIFO_CONFIG_1 0x3E
+#define BMI088_GYRO_FIFO_MODE_SHFITS 0x6
+#define BMI088_GYRO_FIFO_MODE_FIFO (0x1 << BMI088_GYRO_FIFO_MODE_SHFITS)   // stop when full
+#define BMI088_GYRO_FIFO_MODE_STREAM (0x2 << BMI088_GYRO_FIFO_MODE_SHFITS) // overwrite the oldest frames when full
+
+#define BMI088_GYRO_FIFO_DATA 0x3F // burst reads do not increment the address
+
 #endif
 
@@ -66,6 +66,8 @@ typedef struct {
 } DbusData;
 
 void dbus_data_interpret(uint8_t *buff, DbusData *dbus_data);
+void dbus_data_publish(DbusData *dbus_data); // called by dbus_data_interpret
+void dbus_get_data(DbusData *dbus_data);     // coherent copy of the last published frame
 
 
 // global variables
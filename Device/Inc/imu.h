@@ -4,12 +4,51 @@
 #include <stdint.h>
 #include "quaternion.h"
 #include "mahony.h"
+#include "eskf.h"
+#include "gyro_cal.h"
+#include "imu_cal.h"
+#include "heater.h"
+
+// imu sampling mode
+// 0: TIM4 starts a read every 1 ms, whether or not the sensor has latched a new sample
+// 1: the gyro data ready line (INT3, 1000 Hz ODR) starts each read, the filter integrates the measured dt
+#ifndef IMU_USE_DATA_READY
+#define IMU_USE_DATA_READY 0
+#endif
+
+// 1: sensor fifos, gyro at 2 kHz and accel at 1600 Hz are buffered on the sensor,
+//    every TIM4 tick drains all pending frames in one burst per sensor and filters each gyro frame
+#ifndef IMU_USE_FIFO
+#define IMU_USE_FIFO 0
+#endif
+
+#if IMU_USE_FIFO && IMU_USE_DATA_READY
+#error "IMU_USE_FIFO and IMU_USE_DATA_READY are exclusive"
+#endif
+
+// attitude filter
+// 0: mahony, gyro_cal bias only
+// 1: error-state kalman filter, also learns the gyro bias left after gyro_cal
+#ifndef IMU_USE_ESKF
+#define IMU_USE_ESKF 0
+#endif
+
+// 1: hold the sensor at HEATER_TARGET with the TIM3 heater, gyro_cal waits for imu_heater.ready
+#ifndef IMU_USE_HEATER
+#define IMU_USE_HEATER 1
+#endif
 
 typedef struct
 {
-    float accel[3]; // x, y, z
-    float temp;
-    float gyro[3]; // x, y, z
+    // sensor values, only the scalar sensitivity applied, imu_cal_fit input
+    float accel[3]; // g, x, y, z
+    float temp;     // degC
+    float gyro[3];  // rad/s, x, y, z
+
+    // data ready mode only
+    uint32_t gyro_stamp;  // us, TIM2 when the gyro sample was latched
+    uint32_t accel_stamp; // us, TIM2 when the last accel sample was latched
+    float dt;             // s, between the last two gyro samples
 } ImuRawData;
 
 typedef struct
@@ -27,10 +66,58 @@ typedef struct
     float velocity_yaw;
 } ImuData;
 
-uint8_t imu_init(void);
+typedef struct
+{
+    uint32_t complete;   // bursts decoded
+    uint32_t unfiltered; // decoded bursts replaced by the next one before imu_filter_run took them
+    uint32_t overrun;  // TIM4 ticks skipped because the previous burst was still running
+    uint32_t error;    // spi / dma failures
+    uint32_t stale;    // TIM4 ticks that saw no gyro data ready for over 2 ms (data ready mode)
+
+    // fifo mode
+    uint32_t samples;      // gyro frames filtered
+    uint32_t fifo_overrun; // drains that found the gyro fifo overrun, frames were lost
+    uint32_t fifo_peak;    // most gyro frames in one drain
+} ImuDmaStat;
+
+// bmi088 bring-up, stepped once per imu_update
+typedef enum
+{
+    IMU_INIT_IDLE = 0,   // imu_init not called yet
+    IMU_INIT_RESET,      // soft reset both sensors
+    IMU_INIT_RESET_WAIT, // wait for the gyro to start up
+    IMU_INIT_CHIP_ID,    // check the "who am i"
+    IMU_INIT_WRITE,      // write one register of each sensor
+    IMU_INIT_VERIFY,     // read them back
+    IMU_INIT_READY,
+} ImuInitState;
+
+typedef struct
+{
+    ImuInitState state;
+    uint8_t error;       // bmi_error_type of the last failed attempt, cleared when ready
+    uint32_t retries;    // attempts restarted from the soft reset
+    uint32_t ready_time; // us, TIM2 when the sensors were configured, boot-to-ready time
+} ImuInitStat;
+
+void imu_init(void); // does not wait, imu_update configures the sensors over the next ~45 ms
 // void imu_get_data(ImuRawData *data);
 void imu_update(void);
 
+// coherent copy of the last filter output
+void imu_read_data(ImuData *data);
+uint8_t imu_is_ready(void); // 1 once the sensors are configured and the filter runs
+uint8_t imu_sample_pending(void); // 1 while a burst is on the bus
+// called from the spi dma interrupt when a burst is decoded or dropped
+void imu_set_done_callback(void (*callback)(void));
+// filter and publish the last decoded burst, at the tick priority, the dma interrupt only decodes
+uint8_t imu_filter_pending(void);
+void imu_filter_run(void);
+
+// data ready interrupts, called from HAL_GPIO_EXTI_Callback
+void imu_gyro_data_ready(void);
+void imu_accel_data_ready(void);
+
 typedef enum
 {
     BMI088_NO_ERROR = 0x00,
@@ -43,6 +130,10 @@ typedef enum
     BMI088_ACC_CONF_ERROR = 0x05,     //
     BMI088_ACC_PWR_CTRL_ERROR = 0x06, //
     BMI088_ACC_PWR_CONF_ERROR = 0x07, //
+    BMI088_ACC_INT_ERROR = 0x08,      //
+    BMI088_GYRO_INT_ERROR = 0x09,     //
+    BMI088_ACC_FIFO_ERROR = 0x0A,     //
+    BMI088_GYRO_FIFO_ERROR = 0x0B,    //
 
     BMI088_SELF_TEST_ACCEL_ERROR = 0x80, //
     BMI088_SELF_TEST_GYRO_ERROR = 0x40,  //
@@ -52,6 +143,12 @@ typedef enum
 // global variables
 extern ImuRawData imu_raw_data;
 extern MahonyFilter mahony_filter;
+extern EskfFilter eskf_filter;
+extern GyroCal gyro_cal;
+extern ImuCal imu_cal;
+extern Heater imu_heater;
 extern ImuData imu_data;
+extern ImuDmaStat imu_dma_stat;
+extern ImuInitStat imu_init_stat;
 
 #endif // __IMU_H__
@@ -2,6 +2,16 @@
 #define __MOTOR_H__
 
 #include <stdint.h>
+#include "pll.h"
+#include "motor_topology.h"
+
+#define MOTOR_OFFLINE_US (20000)      // no feedback for this long: offline, escs report at 1 kHz
+#define MOTOR_RATE_WINDOW_US (100000) // frame rate averaging window
+#define MOTOR_ENCODER_COUNTS (8192)     // raw_angle per rotor turn
+
+// gearbox, rotor turns per output shaft turn
+#define M3508_REDUCTION_RATIO (3591.0f / 187.0f)
+#define M2006_REDUCTION_RATIO (36.0f)
 
 typedef enum
 {
@@ -21,36 +31,88 @@ typedef struct
     float velocity; // rad/s
     float current;  // A
 
+    // pll observer on the angle and rpm, smooth below 1 rpm
+    float angle_est;    // rad, 0 ~ 2pi
+    float velocity_est; // rad/s
+
+    // multi-turn, the first frame is taken within half a rotor turn of zero_angle
+    int32_t turns;      // rotor turns counted since the first frame
+    float total_angle;  // rad, rotor, continuous from zero_angle
+    float output_angle; // rad, output shaft, total_angle / reduction
+    float zero_offset;  // rad, -pi ~ pi, raw_angle - zero_angle wrapped, full resolution at any turn count,
+                        // the output heading of a direct drive motor
+
+    uint32_t stamp; // us, TIM2 when the frame was decoded
+    uint32_t seq;   // frames received, 0: none yet
+
+    // frame rate over MOTOR_RATE_WINDOW_US, closed by the first frame past the window, motor_rate_hz decays it
+    float rate;          // Hz, last closed window
+    uint32_t rate_start; // us, when the current window opened
+    uint32_t rate_seq;   // seq when the current window opened
+
     MotorType type;
+    float reduction;     // rotor turns per output turn, 0 is taken as direct drive
+    uint16_t zero_angle; // raw_angle of the output zero
 } MotorInfo;
 
 typedef enum
 {
-    // can1: 4 x M3508 + 1 x GM6020
-    CHASSIS_FR = 0, // CAN1 ID 1, M3508, Identifier 0x201
-    CHASSIS_FL,     // CAN1 ID 2, M3508, Identifier 0x202
-    CHASSIS_BL,     // CAN1 ID 3, M3508, Identifier 0x203
-    CHASSIS_BR,     // CAN1 ID 4, M3508, Identifier 0x204
-    GIMBAL_YAW,     // CAN1 ID 5, GM6020, Identifier 0x209
-
-    // can3: 2 x M3508 + 1 x GM6020 + 1 x M2006
-    GIMBAL_PITCH, // CAN3 ID 1, GM6020, Identifier 0x205
-    FRICTION_L,   // CAN3 ID 6, M3508, Identifier 0x206
-    FRICTION_R,   // CAN3 ID 7, M3508, Identifier 0x207
-    TRIGGER,      // CAN3 ID 8, M2006, Identifier 0x208
-
-    TOTAL_MOTOR_NUM // 9 motors in total
+    MOTOR_CAN1 = 0, // hfdcan1, feedback on rx fifo 0
+    MOTOR_CAN3,     // hfdcan3, feedback on rx fifo 1
+
+    MOTOR_BUS_NUM
+} MotorBus;
+
+// ids, buses and command slots in motor_topology.h
+#define MOTOR_INDEX_ENTRY(index, type, bus, rx_id, frame, slot, reduction, zero) index,
+typedef enum
+{
+    MOTOR_TOPOLOGY(MOTOR_INDEX_ENTRY)
+
+    TOTAL_MOTOR_NUM
 } Motor_Index;
+#undef MOTOR_INDEX_ENTRY
+
+typedef struct
+{
+    uint32_t gap_max;  // us, longest time between two frames
+    uint32_t dropouts; // gaps longer than MOTOR_OFFLINE_US, counted when the motor comes back
+} MotorLinkStat;
+
+// command frames, in motor_topology.h
+#define MOTOR_TX_FRAME_ENTRY(frame, bus, std_id) frame,
+typedef enum
+{
+    MOTOR_TX_TOPOLOGY(MOTOR_TX_FRAME_ENTRY)
+
+    MOTOR_TX_NUM
+} MotorTxFrame;
+#undef MOTOR_TX_FRAME_ENTRY
+
+typedef struct
+{
+    uint32_t sent;      // frames accepted by the tx fifo
+    uint32_t dropped;   // staged commands replaced before they reached the bus
+    uint32_t late;      // frames that went out on a later flush than the one they were staged for
+    uint32_t fifo_full; // flushes that found the tx fifo full, the frame is kept for the next flush
+} MotorTxStat;
 
 void motor_init(void);
 void motor_data_interpret(uint8_t *buff, MotorInfo *motor);
+void motor_get_info(Motor_Index index, MotorInfo *info); // coherent copy of the last frame of one motor
+uint8_t motor_is_online(Motor_Index index);              // feedback within MOTOR_OFFLINE_US
+uint32_t motor_age_us(const MotorInfo *info);            // time since the frame of a copy was decoded
+float motor_rate_hz(const MotorInfo *info);              // frame rate of a copy, falls while the frames stop
 
 // motor control interface
 void motor_set_body_current(float c_fr, float c_fl, float c_bl, float c_br);
 void motor_set_neck_voltage(float v_yaw);
 void motor_set_head_command(float v_pitch, float c_friction_left, float c_friction_right, float v_trigger);
+void motor_flush_commands(void); // push the staged command frames, once per scheduler tick
 
 // global variables
 extern MotorInfo motors[TOTAL_MOTOR_NUM];
+extern MotorTxStat motor_tx_stat[MOTOR_TX_NUM];
+extern MotorLinkStat motor_link_stat[TOTAL_MOTOR_NUM];
 
 #endif //__MOTOR_H__
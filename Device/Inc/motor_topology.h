@@ -0,0 +1,40 @@
+#ifndef __MOTOR_TOPOLOGY_H__
+#define __MOTOR_TOPOLOGY_H__
+
+/*
+ * motor topology, the one table that says which esc sits where
+ * everything per motor is generated from it at compile time:
+ *   motor.h    Motor_Index and MotorTxFrame
+ *   motor.c    motors[] defaults, snapshots, observers and the command slot of each motor
+ *   bsp_fdcan  rx dispatch maps (feedback id to motor) and the hardware filter lists
+ * adding a motor is one row here plus the control code that commands it
+ *
+ * dji esc ids:
+ *   feedback 0x200 + id
+ *   M3508 / M2006 current, id 1~4: 0x200, id 5~8: 0x1FF
+ *   GM6020 voltage, id 1~4: 0x1FF, id 5~7: 0x2FF
+ *   slot = (id - 1) % 4, two bytes big endian each
+ * the row order is the Motor_Index order
+ */
+
+// X(index, type, bus, feedback id, command frame, slot, reduction, zero angle)
+#define MOTOR_TOPOLOGY(X)                                                                                        \
+    /* can1: 4 x M3508 + 1 x GM6020 */                                                                           \
+    X(CHASSIS_FR, M3508, MOTOR_CAN1, 0x201, MOTOR_TX_BODY, 0, M3508_REDUCTION_RATIO, 0)                          \
+    X(CHASSIS_FL, M3508, MOTOR_CAN1, 0x202, MOTOR_TX_BODY, 1, M3508_REDUCTION_RATIO, 0)                          \
+    X(CHASSIS_BL, M3508, MOTOR_CAN1, 0x203, MOTOR_TX_BODY, 2, M3508_REDUCTION_RATIO, 0)                          \
+    X(CHASSIS_BR, M3508, MOTOR_CAN1, 0x204, MOTOR_TX_BODY, 3, M3508_REDUCTION_RATIO, 0)                          \
+    X(GIMBAL_YAW, GM6020, MOTOR_CAN1, 0x209, MOTOR_TX_NECK, 0, 1.0f, 3406) /* id 5, zero facing forward */       \
+    /* can3: 1 x GM6020 + 2 x M3508 + 1 x M2006 */                                                               \
+    X(GIMBAL_PITCH, GM6020, MOTOR_CAN3, 0x205, MOTOR_TX_HEAD, 0, 1.0f, 1430) /* id 1, zero level */              \
+    X(FRICTION_L, M3508, MOTOR_CAN3, 0x206, MOTOR_TX_HEAD, 1, 1.0f, 0) /* gearbox removed */                     \
+    X(FRICTION_R, M3508, MOTOR_CAN3, 0x207, MOTOR_TX_HEAD, 2, 1.0f, 0)                                           \
+    X(TRIGGER, M2006, MOTOR_CAN3, 0x208, MOTOR_TX_HEAD, 3, M2006_REDUCTION_RATIO, 0)
+
+// X(frame, bus, std id), flushed in this order
+#define MOTOR_TX_TOPOLOGY(X)                                                    \
+    X(MOTOR_TX_BODY, MOTOR_CAN1, 0x200) /* chassis currents */                  \
+    X(MOTOR_TX_NECK, MOTOR_CAN1, 0x2FF) /* gimbal yaw voltage */                \
+    X(MOTOR_TX_HEAD, MOTOR_CAN3, 0x1FF) /* pitch voltage, shooter currents */
+
+#endif // __MOTOR_TOPOLOGY_H__
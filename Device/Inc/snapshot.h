@@ -0,0 +1,35 @@
+#ifndef __SNAPSHOT_H__
+#define __SNAPSHOT_H__
+
+#include <stdint.h>
+
+/*
+ * double-buffered seqlock for data written in one isr and read in others
+ * - the writer fills the slot readers are not using, then bumps seq: it never waits
+ * - each slot has a generation, odd while the writer is filling it
+ * - a reader copies the published slot and retries when its generation was odd or changed across the copy,
+ *   so a copy is exact whether the writer preempts the reader or runs beside it on another core
+ */
+
+typedef struct
+{
+    volatile uint32_t seq;    // number of publishes, the published slot is seq & 1
+    volatile uint32_t gen[2]; // per slot, odd while being written
+    uint32_t size;         // bytes per slot
+    void *slot[2];
+} Snapshot;
+
+// define a snapshot of a given type, e.g. SNAPSHOT_DEFINE(imu_snapshot, ImuData);
+#define SNAPSHOT_DEFINE(name, type) \
+    static type name##_slot[2];     \
+    Snapshot name = {.seq = 0, .size = sizeof(type), .slot = {&name##_slot[0], &name##_slot[1]}}
+
+// writer side, single writer only
+void snapshot_publish(Snapshot *snap, const void *data);
+void *snapshot_write_begin(Snapshot *snap); // returns the free slot to fill in place
+void snapshot_write_end(Snapshot *snap);
+
+// reader side, returns the seq read before the copy (0: nothing published yet), the copy is that publish or a later one
+uint32_t snapshot_read(Snapshot *snap, void *out);
+
+#endif // __SNAPSHOT_H__
@@ -1,5 +1,6 @@
 #include "main.h"
 #include "dbus.h"
+#include "snapshot.h"
 
 /* 
  * some macros defined in dbus.h
@@ -22,6 +23,7 @@
 uint8_t DbusRxBuf[2][DBUS_FRAME_LENGTH] __attribute__((section(".dma12_buffer")));
 uint32_t dbus_tick;
 DbusData dbus_data;
+SNAPSHOT_DEFINE(dbus_snapshot, DbusData);
 
 
 
@@ -57,4 +59,16 @@ void dbus_data_interpret(uint8_t *buff, DbusData *dbus_data)
 
     // keyboard data
     dbus_data->keyboard.key_code = buff[14] | (buff[15] << 8);
+
+    dbus_data_publish(dbus_data);
+}
+
+void dbus_data_publish(DbusData *dbus_data)
+{
+    snapshot_publish(&dbus_snapshot, dbus_data);
+}
+
+void dbus_get_data(DbusData *dbus_data)
+{
+    snapshot_read(&dbus_snapshot, dbus_data);
 }
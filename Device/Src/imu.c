@@ -3,6 +3,7 @@
 #include "bsp_gpio.h"
 #include "bsp_tim.h"
 #include "bmi088_reg.h"
+#include "snapshot.h"
 
 #ifndef PI
 #define PI (3.14159265358979f)
@@ -17,8 +18,38 @@
 #define BMI088_TEMP_FACTOR 0.125f
 #define BMI088_TEMP_OFFSET 23.0f
 
-#define BMI088_COM_WAIT_SENSOR_TIME 150 // communication wait time: 150us
-#define BMI088_LONG_DELAY_TIME 100      // long delay time: 100ms
+#define BMI088_RESET_TIME_US (30000) // gyro start-up after soft reset, the accel needs 1 ms
+
+// dma burst layout: gyro sends address only, accel needs one extra dummy byte
+#define IMU_GYRO_BURST_LEN (1 + 6)     // address, x/y/z
+#define IMU_ACCEL_BURST_LEN (2 + 18)   // address, dummy, 0x12 ~ 0x23
+#define IMU_GYRO_DATA_OFFSET (1)
+#define IMU_ACCEL_DATA_OFFSET (2)
+#define IMU_TEMP_DATA_OFFSET (2 + BMI088_TEMP_M - BMI088_ACCEL_XOUT_L)
+
+// fifo mode: one status read, then every pending gyro frame and a fixed over-read of the accel fifo
+#define IMU_FIFO_GYRO_DT (1.0f / 2000.0f) // s, gyro odr, the fifo samples are integrated at this step
+#define IMU_FIFO_GYRO_FRAME_LEN (6)       // x/y/z
+#define IMU_FIFO_ACCEL_FRAME_LEN (7)      // header, x/y/z
+#define IMU_FIFO_ACCEL_READ (128)         // bytes per tick, 18 frames, 1.6 per ms at 1600 Hz
+#define IMU_FIFO_ACCEL_FRAMES (IMU_FIFO_ACCEL_READ / IMU_FIFO_ACCEL_FRAME_LEN)
+#define IMU_FIFO_STATUS_LEN (1 + 1)                                                  // address, status
+#define IMU_FIFO_GYRO_BURST_LEN (1 + BMI088_GYRO_FIFO_DEPTH * IMU_FIFO_GYRO_FRAME_LEN) // address, frames
+#define IMU_FIFO_ACCEL_BURST_LEN (2 + IMU_FIFO_ACCEL_READ)                            // address, dummy, frames
+#define IMU_FIFO_TEMP_BURST_LEN (2 + 2)                                               // address, dummy, msb, lsb
+#define IMU_FIFO_TEMP_DIVIDER (100) // temperature read every 100 ticks, the sensor updates it every 1.28 s
+#define IMU_HEATER_DIVIDER (100)    // ticks per heater_update, HEATER_PERIOD
+
+#if IMU_USE_FIFO
+#define IMU_DMA_BUFFER_LEN IMU_FIFO_GYRO_BURST_LEN
+#else
+#define IMU_DMA_BUFFER_LEN IMU_ACCEL_BURST_LEN
+#endif
+
+// data ready mode: accepted range of the measured sample interval, nominal otherwise
+#define IMU_DT_MIN (0.2e-3f)        // s
+#define IMU_DT_MAX (5.0e-3f)        // s
+#define IMU_STALE_TIME_US (2000)    // no gyro data ready for this long counts as stale
 
 /*
  **************************************************************************
@@ -51,9 +82,55 @@ MahonyFilter mahony_filter = {
     .ki = 0.0f,
     .i_limit = 0.0f,
     .sample_freq = 1000.0f,
+    .integrator = MAHONY_INTEGRATOR_EXP, // no heading loss while spinning
+    .accel_band = 0.1f,                  // braking / strafing, kp 0 at 0.1 g off, same as the eskf gate
+    .rate_band = 2.0f,                   // spinning, kp halves at 2 rad/s
+    .kp_effective = 0.6f,
+};
+// initialized in imu_init
+EskfFilter eskf_filter;
+// static calibration, paste the initializer printed by build_host/imu_cal_fit for this board
+ImuCal imu_cal = {
+    .accel_matrix = {1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f},
+    .accel_offset = {0.0f, 0.0f, 0.0f},
+    .temp_num = 0,
 };
-// experimental gyro bias
-float gyro_bias[3] = {0.00398518f, 0.00122815f, 0.00283814f};
+// stationary gyro bias calibration, without a temperature table it starts from the bias measured on the first board
+static const float gyro_bias_default[3] = {0.00398518f, 0.00122815f, 0.00283814f};
+GyroCal gyro_cal;
+// sensor temperature control, stepped from the tick once the sensor is configured
+Heater imu_heater;
+static uint8_t imu_heater_count;
+// calibrated sample being filtered, imu_raw_data keeps the sensor values
+static float32_t imu_gyro[3];
+static float32_t imu_accel[3];
+// filter output for the control tasks
+SNAPSHOT_DEFINE(imu_snapshot, ImuData);
+// dma pipeline statistics
+ImuDmaStat imu_dma_stat;
+// set once both sensors are configured, imu_update only steps the init state machine before that
+static volatile uint8_t imu_ready;
+ImuInitStat imu_init_stat;
+// spi2 dma buffers, DMA1 cannot access DTCM
+static uint8_t imu_dma_tx[IMU_DMA_BUFFER_LEN] __attribute__((section(".dma12_buffer")));
+static uint8_t imu_dma_rx[IMU_DMA_BUFFER_LEN] __attribute__((section(".dma12_buffer")));
+static volatile uint8_t imu_dma_busy;
+static void (*volatile imu_done_callback)(void);
+// a burst is decoded, its samples wait for imu_filter_run
+static volatile uint8_t imu_filter_due;
+#if !IMU_USE_FIFO
+// decoded sample handed from the spi dma interrupt to the filter, data ready bursts may start while it runs
+SNAPSHOT_DEFINE(imu_sample_snapshot, ImuRawData);
+#endif
+static volatile uint32_t imu_gyro_stamp; // TIM2 at the data ready of the sample being read
+#if IMU_USE_FIFO
+// frames decoded by the current drain, filtered together once the accel fifo is in
+static float imu_fifo_gyro[BMI088_GYRO_FIFO_DEPTH][3];
+static float imu_fifo_accel[IMU_FIFO_ACCEL_FRAMES][3];
+static uint8_t imu_fifo_gyro_num;
+static uint8_t imu_fifo_accel_num;
+static uint8_t imu_fifo_temp_count = IMU_FIFO_TEMP_DIVIDER - 1; // first drain reads it
+#endif
 
 /*
  **************************************************************************
@@ -118,95 +195,225 @@ static inline void bmi088_gyro_read_multi_reg(uint8_t reg, uint8_t *rx_buf)
     SET_CS_GYRO_HIGH();
 }
 
-// initialize imu
-uint8_t bmi088_accel_init(void)
+// register configuration, written and read back by the init state machine
+typedef struct
 {
-    // configure, set registers and define corresponding errors
-    uint8_t BMI088_Acc_Init_Config[4][3] = {
-        {BMI088_ACC_RANGE, BMI088_ACC_RANGE_3G, BMI088_ACC_RANGE_ERROR},
-        {BMI088_ACC_CONF, BMI088_ACC_800_HZ | BMI088_ACC_CONF_MUST_Set, BMI088_ACC_CONF_ERROR},
-        {BMI088_ACC_PWR_CTRL, BMI088_ACC_ENABLE_ACC_ON, BMI088_ACC_PWR_CTRL_ERROR},
-        {BMI088_ACC_PWR_CONF, BMI088_ACC_PWR_ACTIVE_MODE, BMI088_ACC_PWR_CONF_ERROR}};
-    static uint8_t read_value;
+    uint8_t reg;
+    uint8_t value;
+    uint8_t error; // reported when the readback differs
+} Bmi088RegConfig;
+
+static const Bmi088RegConfig bmi088_accel_config[] = {
+    {BMI088_ACC_RANGE, BMI088_ACC_RANGE_3G, BMI088_ACC_RANGE_ERROR},
+#if IMU_USE_FIFO
+    {BMI088_ACC_CONF, BMI088_ACC_1600_HZ | BMI088_ACC_CONF_MUST_Set, BMI088_ACC_CONF_ERROR},
+#else
+    {BMI088_ACC_CONF, BMI088_ACC_800_HZ | BMI088_ACC_CONF_MUST_Set, BMI088_ACC_CONF_ERROR},
+#endif
+    {BMI088_ACC_PWR_CTRL, BMI088_ACC_ENABLE_ACC_ON, BMI088_ACC_PWR_CTRL_ERROR},
+    {BMI088_ACC_PWR_CONF, BMI088_ACC_PWR_ACTIVE_MODE, BMI088_ACC_PWR_CONF_ERROR},
+#if IMU_USE_FIFO
+    // stream mode, accel frames only
+    {BMI088_ACC_FIFO_CONFIG_0, BMI088_ACC_FIFO_MODE_STREAM, BMI088_ACC_FIFO_ERROR},
+    {BMI088_ACC_FIFO_CONFIG_1, BMI088_ACC_FIFO_ACC_EN | BMI088_ACC_FIFO_CONFIG_1_MUST_Set, BMI088_ACC_FIFO_ERROR},
+#endif
+#if IMU_USE_DATA_READY
+    // data ready on INT1, push-pull, active high
+    {BMI088_INT1_IO_CTRL, BMI088_ACC_INT1_IO_ENABLE | BMI088_ACC_INT1_GPIO_PP | BMI088_ACC_INT1_GPIO_HIGH, BMI088_ACC_INT_ERROR},
+    {BMI088_INT_MAP_DATA, BMI088_ACC_INT1_DRDY_INTERRUPT, BMI088_ACC_INT_ERROR},
+#endif
+};
+#define BMI088_ACCEL_CONFIG_NUM (sizeof(bmi088_accel_config) / sizeof(bmi088_accel_config[0]))
+
+static const Bmi088RegConfig bmi088_gyro_config[] = {
+    {BMI088_GYRO_RANGE, BMI088_GYRO_1000, BMI088_GYRO_RANGE_ERROR},
+#if IMU_USE_FIFO
+    {BMI088_GYRO_BANDWIDTH, BMI088_GYRO_2000_230_HZ | BMI088_GYRO_BANDWIDTH_MUST_Set, BMI088_GYRO_BANDWIDTH_ERROR},
+#else
+    {BMI088_GYRO_BANDWIDTH, BMI088_GYRO_1000_116_HZ | BMI088_GYRO_BANDWIDTH_MUST_Set, BMI088_GYRO_BANDWIDTH_ERROR},
+#endif
+    {BMI088_GYRO_LPM1, BMI088_GYRO_NORMAL_MODE, BMI088_GYRO_LPM1_ERROR},
+#if IMU_USE_FIFO
+    {BMI088_GYRO_FIFO_CONFIG_1, BMI088_GYRO_FIFO_MODE_STREAM, BMI088_GYRO_FIFO_ERROR},
+#endif
+#if IMU_USE_DATA_READY
+    // data ready on INT3, push-pull, active high
+    {BMI088_GYRO_CTRL, BMI088_DRDY_ON, BMI088_GYRO_INT_ERROR},
+    {BMI088_GYRO_INT3_INT4_IO_CONF, BMI088_GYRO_INT3_GPIO_PP | BMI088_GYRO_INT3_GPIO_HIGH, BMI088_GYRO_INT_ERROR},
+    {BMI088_GYRO_INT3_INT4_IO_MAP, BMI088_GYRO_DRDY_IO_INT3, BMI088_GYRO_INT_ERROR},
+#endif
+};
+#define BMI088_GYRO_CONFIG_NUM (sizeof(bmi088_gyro_config) / sizeof(bmi088_gyro_config[0]))
 
-    // software reset, required
-    bmi088_accel_write_single_reg(BMI088_ACC_SOFTRESET, BMI088_ACC_SOFTRESET_VALUE);
-    Delay_ms(BMI088_LONG_DELAY_TIME);
-    bmi088_accel_write_single_reg(BMI088_ACC_PWR_CONF, BMI088_ACC_PWR_ACTIVE_MODE);
-    Delay_us(BMI088_COM_WAIT_SENSOR_TIME);
+static void imu_init_fail(uint8_t error)
+{
+    // start over, the sensor may still be powering up
+    imu_init_stat.error = error;
+    imu_init_stat.retries++;
+    imu_init_stat.state = IMU_INIT_RESET;
+}
 
-    // check commiunication is normal after reset
-    bmi088_accel_read_single_reg(BMI088_ACC_CHIP_ID, &read_value);
-    Delay_us(BMI088_COM_WAIT_SENSOR_TIME);
+// one step per scheduler tick, the 1 ms between steps covers the 450 us the accel needs in suspend mode
+static void imu_init_step(void)
+{
+    static uint32_t reset_stamp;
+    static uint8_t index;
+    uint8_t read_value;
+    uint32_t now = Get_Time_us();
 
-    // check the "who am I"
-    if (read_value != BMI088_ACC_CHIP_ID_VALUE)
+    switch (imu_init_stat.state)
     {
-        return BMI088_NO_SENSOR; //**?
-    }
+    case IMU_INIT_RESET:
+        // both sensors reset in parallel
+        bmi088_accel_write_single_reg(BMI088_ACC_SOFTRESET, BMI088_ACC_SOFTRESET_VALUE);
+        bmi088_gyro_write_single_reg(BMI088_GYRO_SOFTRESET, BMI088_GYRO_SOFTRESET_VALUE);
+        reset_stamp = now;
+        imu_init_stat.state = IMU_INIT_RESET_WAIT;
+        break;
+
+    case IMU_INIT_RESET_WAIT:
+        if (now - reset_stamp < BMI088_RESET_TIME_US)
+        {
+            break;
+        }
+        // the accel comes out of reset in i2c mode, a rising cs edge switches it to spi
+        bmi088_accel_read_single_reg(BMI088_ACC_CHIP_ID, &read_value);
+        imu_init_stat.state = IMU_INIT_CHIP_ID;
+        break;
+
+    case IMU_INIT_CHIP_ID:
+        // check the "who am i"
+        bmi088_accel_read_single_reg(BMI088_ACC_CHIP_ID, &read_value);
+        if (read_value != BMI088_ACC_CHIP_ID_VALUE)
+        {
+            imu_init_fail(BMI088_NO_SENSOR);
+            break;
+        }
+        bmi088_gyro_read_single_reg(BMI088_GYRO_CHIP_ID, &read_value);
+        if (read_value != BMI088_GYRO_CHIP_ID_VALUE)
+        {
+            imu_init_fail(BMI088_NO_SENSOR);
+            break;
+        }
+        index = 0;
+        imu_init_stat.state = IMU_INIT_WRITE;
+        break;
 
-    // write register
-    for (uint8_t i = 0; i < 4; i++)
-    {
-        bmi088_accel_write_single_reg(BMI088_Acc_Init_Config[i][0], BMI088_Acc_Init_Config[i][1]);
-        Delay_us(BMI088_COM_WAIT_SENSOR_TIME);
-        bmi088_accel_read_single_reg(BMI088_Acc_Init_Config[i][0], &read_value);
-        Delay_us(BMI088_COM_WAIT_SENSOR_TIME);
-        if (read_value != BMI088_Acc_Init_Config[i][1])
+    case IMU_INIT_WRITE:
+        // the two tables are written side by side
+        if (index < BMI088_ACCEL_CONFIG_NUM)
+        {
+            bmi088_accel_write_single_reg(bmi088_accel_config[index].reg, bmi088_accel_config[index].value);
+        }
+        if (index < BMI088_GYRO_CONFIG_NUM)
+        {
+            bmi088_gyro_write_single_reg(bmi088_gyro_config[index].reg, bmi088_gyro_config[index].value);
+        }
+        imu_init_stat.state = IMU_INIT_VERIFY;
+        break;
+
+    case IMU_INIT_VERIFY:
+        if (index < BMI088_ACCEL_CONFIG_NUM)
+        {
+            bmi088_accel_read_single_reg(bmi088_accel_config[index].reg, &read_value);
+            if (read_value != bmi088_accel_config[index].value)
+            {
+                imu_init_fail(bmi088_accel_config[index].error);
+                break;
+            }
+        }
+        if (index < BMI088_GYRO_CONFIG_NUM)
         {
-            return BMI088_Acc_Init_Config[i][2]; // return if error occurs
+            bmi088_gyro_read_single_reg(bmi088_gyro_config[index].reg, &read_value);
+            if (read_value != bmi088_gyro_config[index].value)
+            {
+                imu_init_fail(bmi088_gyro_config[index].error);
+                break;
+            }
         }
+
+        index++;
+        if (index < BMI088_ACCEL_CONFIG_NUM || index < BMI088_GYRO_CONFIG_NUM)
+        {
+            imu_init_stat.state = IMU_INIT_WRITE;
+            break;
+        }
+
+        // configured, sampling starts on the next tick or data ready edge
+        imu_init_stat.error = BMI088_NO_ERROR;
+        imu_init_stat.ready_time = now;
+        imu_gyro_stamp = now;
+        imu_init_stat.state = IMU_INIT_READY;
+        imu_ready = 1;
+        break;
+
+    case IMU_INIT_IDLE:
+    case IMU_INIT_READY:
+    default:
+        break;
     }
-    return BMI088_NO_ERROR;
 }
 
-uint8_t bmi088_gyro_init(void)
+void imu_init(void)
 {
-    uint8_t BMI088_Gyro_Init_Config[3][3] = {
-        {BMI088_GYRO_RANGE, BMI088_GYRO_1000, BMI088_GYRO_RANGE_ERROR},
-        {BMI088_GYRO_BANDWIDTH, BMI088_GYRO_1000_116_HZ | BMI088_GYRO_BANDWIDTH_MUST_Set, BMI088_GYRO_BANDWIDTH_ERROR},
-        {BMI088_GYRO_LPM1, BMI088_GYRO_NORMAL_MODE, BMI088_GYRO_LPM1_ERROR}};
-    static uint8_t read_value;
-
-    bmi088_gyro_write_single_reg(BMI088_GYRO_SOFTRESET, BMI088_GYRO_SOFTRESET_VALUE);
-    Delay_ms(BMI088_LONG_DELAY_TIME);
-
-    // check commiunication is normal after reset
-    bmi088_gyro_read_single_reg(BMI088_GYRO_CHIP_ID, &read_value);
-    Delay_us(BMI088_COM_WAIT_SENSOR_TIME);
+    static const float32_t no_bias[3] = {0.0f, 0.0f, 0.0f};
+    gyro_cal_init(&gyro_cal, imu_cal.temp_num > 0 ? no_bias : gyro_bias_default, GYRO_CAL_WINDOW);
+    eskf_init(&eskf_filter, ESKF_GYRO_NOISE, ESKF_BIAS_WALK, ESKF_ACCEL_NOISE, mahony_filter.sample_freq);
+    heater_init(&imu_heater, HEATER_TARGET);
+    imu_heater_count = 0;
+
+    // dummy bytes clocked out during the dma reads
+    memset(imu_dma_tx, 0x55, sizeof(imu_dma_tx));
+
+    // the sensors are configured by imu_update from the scheduler tick, nothing here waits
+    imu_ready = 0;
+    imu_init_stat.state = IMU_INIT_RESET;
+}
 
-    // check the "who am I"
-    if (read_value != BMI088_GYRO_CHIP_ID_VALUE)
-    {
-        return BMI088_NO_SENSOR;
-    }
+// data decoding functions
+static inline void imu_decode_gyro(uint8_t *gyro_buff, ImuRawData *data)
+{
+    int16_t tmp;
+    tmp = (int16_t)((gyro_buff[1] << 8) | gyro_buff[0]);
+    data->gyro[0] = ((float)tmp / GYRO_SENSITIVITY_1000) * _PI_OVER_180; // in radians
+    tmp = (int16_t)((gyro_buff[3] << 8) | gyro_buff[2]);
+    data->gyro[1] = ((float)tmp / GYRO_SENSITIVITY_1000) * _PI_OVER_180;
+    tmp = (int16_t)((gyro_buff[5] << 8) | gyro_buff[4]);
+    data->gyro[2] = ((float)tmp / GYRO_SENSITIVITY_1000) * _PI_OVER_180;
+}
 
-    // configure registers
-    for (uint8_t i = 0; i < 3; i++)
-    {
-        bmi088_gyro_write_single_reg(BMI088_Gyro_Init_Config[i][0], BMI088_Gyro_Init_Config[i][1]);
-        Delay_us(BMI088_COM_WAIT_SENSOR_TIME);
-        bmi088_gyro_read_single_reg(BMI088_Gyro_Init_Config[i][0], &read_value);
-        Delay_us(BMI088_COM_WAIT_SENSOR_TIME);
-        if (read_value != BMI088_Gyro_Init_Config[i][1])
-        {
-            return BMI088_Gyro_Init_Config[i][2]; // return if error occurs
-        }
-    }
-    return BMI088_NO_ERROR;
+// x/y/z little endian, scaled
+static inline void imu_decode_vector(const uint8_t *buff, float scale, float out[3])
+{
+    out[0] = (float)(int16_t)((buff[1] << 8) | buff[0]) * scale;
+    out[1] = (float)(int16_t)((buff[3] << 8) | buff[2]) * scale;
+    out[2] = (float)(int16_t)((buff[5] << 8) | buff[4]) * scale;
 }
 
-uint8_t imu_init(void)
+static inline void imu_decode_accel(uint8_t *accel_buff, ImuRawData *data)
 {
-    uint8_t state = BMI088_NO_ERROR;
-    // uint8_t state = BMI088_NO_ERROR;
-    state |= bmi088_gyro_init();
-    state |= bmi088_accel_init();
+    // the unit is g
+    int16_t tmp;
+    tmp = (int16_t)((accel_buff[1] << 8) | accel_buff[0]);
+    data->accel[0] = ((float)tmp / ACCEL_SENSITIVITY_3);
+    tmp = (int16_t)((accel_buff[3] << 8) | accel_buff[2]);
+    data->accel[1] = ((float)tmp / ACCEL_SENSITIVITY_3);
+    tmp = (int16_t)((accel_buff[5] << 8) | accel_buff[4]);
+    data->accel[2] = ((float)tmp / ACCEL_SENSITIVITY_3);
+}
 
-    return state;
+static inline void imu_decode_temp(uint8_t *temp_buff, ImuRawData *data)
+{
+    // temp_buff[0]: TEMP_MSB, temp_buff[1]: TEMP_LSB
+    int16_t tmp = (int16_t)((temp_buff[0] << 3) | (temp_buff[1] >> 5));
+    if (tmp > 1023)
+    {
+        tmp -= 2048;
+    }
+    data->temp = (float)tmp * BMI088_TEMP_FACTOR + BMI088_TEMP_OFFSET;
 }
 
-// data reading functions
+// blocking data reading functions
 void bmi088_get_temperature(uint8_t *tempbuff)
 {
     uint8_t bmi_tx_byte, len = 2;
@@ -230,63 +437,499 @@ void imu_get_data(ImuRawData *data)
     uint8_t gyro_buff[6];
     uint8_t accel_buff[6];
     uint8_t temp_buff[2];
-    int16_t tmp;
 
     // read gyro data
     bmi088_gyro_read_multi_reg(BMI088_GYRO_X_L, gyro_buff);
-    tmp = (int16_t)((gyro_buff[1] << 8) | gyro_buff[0]);
-    data->gyro[0] = ((float)tmp / GYRO_SENSITIVITY_1000) * _PI_OVER_180 - gyro_bias[0]; // in radians
-    tmp = (int16_t)((gyro_buff[3] << 8) | gyro_buff[2]);
-    data->gyro[1] = ((float)tmp / GYRO_SENSITIVITY_1000) * _PI_OVER_180 - gyro_bias[1];
-    tmp = (int16_t)((gyro_buff[5] << 8) | gyro_buff[4]);
-    data->gyro[2] = ((float)tmp / GYRO_SENSITIVITY_1000) * _PI_OVER_180 - gyro_bias[2];
+    imu_decode_gyro(gyro_buff, data);
 
-    // read accel data, the unit is g
+    // read accel data
     bmi088_accel_read_multi_reg(BMI088_ACCEL_XOUT_L, accel_buff);
-    tmp = (int16_t)((accel_buff[1] << 8) | accel_buff[0]);
-    data->accel[0] = ((float)tmp / ACCEL_SENSITIVITY_3);
-    tmp = (int16_t)((accel_buff[3] << 8) | accel_buff[2]);
-    data->accel[1] = ((float)tmp / ACCEL_SENSITIVITY_3);
-    tmp = (int16_t)((accel_buff[5] << 8) | accel_buff[4]);
-    data->accel[2] = ((float)tmp / ACCEL_SENSITIVITY_3);
+    imu_decode_accel(accel_buff, data);
 
     // read temperature data
     bmi088_get_temperature(temp_buff);
-    tmp = (int16_t)((temp_buff[0] << 3) | (temp_buff[1] >> 5));
-    if (tmp > 1023)
+    imu_decode_temp(temp_buff, data);
+}
+
+/*
+ **************************************************************************
+ * spi2 dma burst pipeline
+ * TIM4 starts the gyro burst, its completion starts the accel + temperature burst,
+ * whose completion decodes the samples and pends the filter, imu_filter_run filters them at the tick priority.
+ * cs is toggled in the callbacks
+ **************************************************************************
+ */
+static void imu_filter_sample(const ImuRawData *raw, float32_t dt);
+static void imu_filter_publish(void);
+#if !IMU_USE_FIFO
+static void imu_accel_burst_done(HAL_StatusTypeDef status);
+#endif
+
+// decoded, the filter runs once the callback pends it
+static void imu_sample_done(void)
+{
+    if (imu_filter_due)
     {
-        tmp -= 2048;
+        imu_dma_stat.unfiltered++;
+    }
+    imu_filter_due = 1;
+}
+
+// burst over, published or not
+static void imu_dma_done(void)
+{
+    imu_dma_busy = 0;
+    if (imu_done_callback != NULL)
+    {
+        imu_done_callback();
+    }
+}
+
+static void imu_dma_abort(void)
+{
+    SET_CS_GYRO_HIGH();
+    SET_CS_ACCEL_HIGH();
+    imu_dma_stat.error++;
+    imu_dma_done();
+}
+
+#if !IMU_USE_FIFO
+static void imu_gyro_burst_done(HAL_StatusTypeDef status)
+{
+    SET_CS_GYRO_HIGH();
+    if (status != HAL_OK)
+    {
+        imu_dma_abort();
+        return;
+    }
+    imu_decode_gyro(&imu_dma_rx[IMU_GYRO_DATA_OFFSET], &imu_raw_data);
+#if IMU_USE_DATA_READY
+    imu_raw_data.dt = (imu_gyro_stamp - imu_raw_data.gyro_stamp) * 1.0e-6f;
+    imu_raw_data.gyro_stamp = imu_gyro_stamp;
+#endif
+
+    // accel read: address, one dummy byte, then data, 0x12 ~ 0x23 covers accel and temperature
+    imu_dma_tx[0] = BMI088_ACCEL_XOUT_L | 0x80;
+    SET_CS_ACCEL_LOW();
+    if (SPI2_Transfer_DMA(imu_dma_tx, imu_dma_rx, IMU_ACCEL_BURST_LEN, imu_accel_burst_done) != HAL_OK)
+    {
+        imu_dma_abort();
+    }
+}
+
+static void imu_accel_burst_done(HAL_StatusTypeDef status)
+{
+    SET_CS_ACCEL_HIGH();
+    if (status != HAL_OK)
+    {
+        imu_dma_abort();
+        return;
+    }
+    imu_decode_accel(&imu_dma_rx[IMU_ACCEL_DATA_OFFSET], &imu_raw_data);
+    imu_decode_temp(&imu_dma_rx[IMU_TEMP_DATA_OFFSET], &imu_raw_data);
+    imu_dma_stat.complete++;
+
+    snapshot_publish(&imu_sample_snapshot, &imu_raw_data);
+    imu_sample_done();
+    imu_dma_done(); // sample decoded
+}
+#endif
+
+#if IMU_USE_FIFO
+/*
+ **************************************************************************
+ * fifo drain, IMU_USE_FIFO
+ * gyro fifo status -> all pending gyro frames -> accel fifo over-read -> (temperature) -> filter,
+ * every gyro frame goes through the filter at the gyro odr, the accel frames are spread over them
+ **************************************************************************
+ */
+static void imu_fifo_accel_start(void);
+static void imu_fifo_status_done(HAL_StatusTypeDef status);
+static void imu_fifo_gyro_done(HAL_StatusTypeDef status);
+static void imu_fifo_accel_done(HAL_StatusTypeDef status);
+static void imu_fifo_temp_done(HAL_StatusTypeDef status);
+
+static void imu_fifo_start(void)
+{
+    imu_fifo_gyro_num = 0;
+    imu_fifo_accel_num = 0;
+
+    // gyro fifo status: address, then overrun flag and frame count
+    imu_dma_tx[0] = BMI088_GYRO_FIFO_STATUS | 0x80;
+    SET_CS_GYRO_LOW();
+    if (SPI2_Transfer_DMA(imu_dma_tx, imu_dma_rx, IMU_FIFO_STATUS_LEN, imu_fifo_status_done) != HAL_OK)
+    {
+        imu_dma_abort();
+    }
+}
+
+static void imu_fifo_status_done(HAL_StatusTypeDef status)
+{
+    SET_CS_GYRO_HIGH();
+    if (status != HAL_OK)
+    {
+        imu_dma_abort();
+        return;
+    }
+    uint8_t fifo_status = imu_dma_rx[1];
+    if (fifo_status & BMI088_GYRO_FIFO_OVERRUN)
+    {
+        imu_dma_stat.fifo_overrun++;
+    }
+
+    // frames arriving from now on are left for the next tick
+    imu_fifo_gyro_num = fifo_status & BMI088_GYRO_FIFO_FRAME_COUNT_MASK;
+    if (imu_fifo_gyro_num > BMI088_GYRO_FIFO_DEPTH)
+    {
+        imu_fifo_gyro_num = BMI088_GYRO_FIFO_DEPTH;
+    }
+    if (imu_fifo_gyro_num == 0)
+    {
+        imu_fifo_accel_start();
+        return;
+    }
+
+    imu_dma_tx[0] = BMI088_GYRO_FIFO_DATA | 0x80;
+    SET_CS_GYRO_LOW();
+    if (SPI2_Transfer_DMA(imu_dma_tx, imu_dma_rx, 1 + imu_fifo_gyro_num * IMU_FIFO_GYRO_FRAME_LEN,
+                          imu_fifo_gyro_done) != HAL_OK)
+    {
+        imu_dma_abort();
     }
-    data->temp = (float)tmp * BMI088_TEMP_FACTOR + BMI088_TEMP_OFFSET;
 }
 
+static void imu_fifo_gyro_done(HAL_StatusTypeDef status)
+{
+    SET_CS_GYRO_HIGH();
+    if (status != HAL_OK)
+    {
+        imu_dma_abort();
+        return;
+    }
+    for (int i = 0; i < imu_fifo_gyro_num; i++)
+    {
+        imu_decode_vector(&imu_dma_rx[1 + i * IMU_FIFO_GYRO_FRAME_LEN], _PI_OVER_180 / GYRO_SENSITIVITY_1000,
+                          imu_fifo_gyro[i]);
+    }
+    imu_fifo_accel_start();
+}
+
+static void imu_fifo_accel_start(void)
+{
+    // reading past the last frame returns empty headers, so a fixed length needs no length read
+    imu_dma_tx[0] = BMI088_ACC_FIFO_DATA | 0x80;
+    SET_CS_ACCEL_LOW();
+    if (SPI2_Transfer_DMA(imu_dma_tx, imu_dma_rx, IMU_FIFO_ACCEL_BURST_LEN, imu_fifo_accel_done) != HAL_OK)
+    {
+        imu_dma_abort();
+    }
+}
+
+// the next drain starts from the next tick, after the filter has run on these frames
+static void imu_fifo_done(void)
+{
+    imu_dma_stat.complete++;
+    imu_dma_stat.samples += imu_fifo_gyro_num;
+    if (imu_fifo_gyro_num > imu_dma_stat.fifo_peak)
+    {
+        imu_dma_stat.fifo_peak = imu_fifo_gyro_num;
+    }
+    imu_sample_done();
+    imu_dma_done(); // samples decoded
+}
+
+static void imu_fifo_filter(void)
+{
+    // the accel runs slower than the gyro, frame k is used from gyro frame k * gyro_num / accel_num on
+    for (int i = 0; i < imu_fifo_gyro_num; i++)
+    {
+        if (imu_fifo_accel_num > 0)
+        {
+            int k = i * imu_fifo_accel_num / imu_fifo_gyro_num;
+            memcpy(imu_raw_data.accel, imu_fifo_accel[k], sizeof(imu_raw_data.accel));
+        }
+        memcpy(imu_raw_data.gyro, imu_fifo_gyro[i], sizeof(imu_raw_data.gyro));
+        imu_filter_sample(&imu_raw_data, IMU_FIFO_GYRO_DT);
+    }
+    if (imu_fifo_gyro_num > 0)
+    {
+        imu_filter_publish();
+    }
+}
+
+static void imu_fifo_accel_done(HAL_StatusTypeDef status)
+{
+    SET_CS_ACCEL_HIGH();
+    if (status != HAL_OK)
+    {
+        imu_dma_abort();
+        return;
+    }
+
+    // header mode frames, a frame cut by the end of the read is sent again next time
+    int i = 2;
+    while (i < IMU_FIFO_ACCEL_BURST_LEN)
+    {
+        uint8_t header = imu_dma_rx[i] & BMI088_ACC_FIFO_HEADER_MASK;
+        int len;
+        if (header == BMI088_ACC_FIFO_HEADER_ACC)
+        {
+            len = IMU_FIFO_ACCEL_FRAME_LEN;
+        }
+        else if (header == BMI088_ACC_FIFO_HEADER_TIME)
+        {
+            len = 1 + 3;
+        }
+        else if (header == BMI088_ACC_FIFO_HEADER_SKIP || header == BMI088_ACC_FIFO_HEADER_CONFIG ||
+                 header == BMI088_ACC_FIFO_HEADER_DROP)
+        {
+            len = 1 + 1;
+        }
+        else
+        {
+            break; // empty
+        }
+        if (i + len > IMU_FIFO_ACCEL_BURST_LEN)
+        {
+            break;
+        }
+
+        if (header == BMI088_ACC_FIFO_HEADER_ACC && imu_fifo_accel_num < IMU_FIFO_ACCEL_FRAMES)
+        {
+            imu_decode_vector(&imu_dma_rx[i + 1], 1.0f / ACCEL_SENSITIVITY_3, imu_fifo_accel[imu_fifo_accel_num]);
+            imu_fifo_accel_num++;
+        }
+        i += len;
+    }
+
+    if (++imu_fifo_temp_count < IMU_FIFO_TEMP_DIVIDER)
+    {
+        imu_fifo_done();
+        return;
+    }
+    imu_fifo_temp_count = 0;
+
+    // temperature: address, dummy, msb, lsb
+    imu_dma_tx[0] = BMI088_TEMP_M | 0x80;
+    SET_CS_ACCEL_LOW();
+    if (SPI2_Transfer_DMA(imu_dma_tx, imu_dma_rx, IMU_FIFO_TEMP_BURST_LEN, imu_fifo_temp_done) != HAL_OK)
+    {
+        imu_dma_abort();
+    }
+}
+
+static void imu_fifo_temp_done(HAL_StatusTypeDef status)
+{
+    SET_CS_ACCEL_HIGH();
+    if (status != HAL_OK)
+    {
+        imu_dma_abort();
+        return;
+    }
+    imu_decode_temp(&imu_dma_rx[2], &imu_raw_data);
+    imu_fifo_done();
+}
+#endif
+
 /*
  **************************************************************************
  * data update implementation
  **************************************************************************
  */
-void imu_update(void)
+// gyro bias and attitude filter on one raw sample
+static void imu_filter_sample(const ImuRawData *raw, float32_t dt)
+{
+    // scale, cross-axis coupling and temperature bias
+    imu_cal_accel(&imu_cal, raw->accel, imu_accel);
+    imu_cal_gyro(&imu_cal, raw->gyro, raw->temp, imu_gyro);
+
+    // calibrate on still samples, then remove the bias
+    // while warming up the bias is still moving with the temperature
+    float32_t bias_last[3] = {gyro_cal.bias[0], gyro_cal.bias[1], gyro_cal.bias[2]};
+    if ((!IMU_USE_HEATER || imu_heater.ready) && gyro_cal_update(&gyro_cal, imu_gyro, imu_accel))
+    {
+        // the eskf estimate is relative to the calibrated bias
+        for (int i = 0; i < 3; i++)
+        {
+            eskf_filter.bias[i] -= gyro_cal.bias[i] - bias_last[i];
+        }
+    }
+    gyro_cal_apply(&gyro_cal, imu_gyro);
+
+    // update quaternion using the selected filter
+#if IMU_USE_ESKF
+    eskf_update_dt(&eskf_filter, imu_gyro, imu_accel, dt);
+#else
+    mahony_update_dt(&mahony_filter, imu_gyro, imu_accel, dt);
+#endif
+}
+
+// rates and angles of the last sample for the control tasks
+static void imu_filter_publish(void)
 {
     // temporary array
     float32_t euler[3]; // euler angle
     float32_t w[3];     // angular velocity under world frame
 
-    // update raw data
-    imu_get_data(&imu_raw_data);
+#if IMU_USE_ESKF
+    imu_data.q = eskf_filter.q;
+#else
+    imu_data.q = mahony_filter.q;
+#endif
 
     // update imu velocity data
-    quat_rotate_vector(&(imu_data.q), imu_raw_data.gyro, w);
+#if IMU_USE_ESKF
+    float32_t gyro[3] = {imu_gyro[0] - eskf_filter.bias[0],
+                         imu_gyro[1] - eskf_filter.bias[1],
+                         imu_gyro[2] - eskf_filter.bias[2]};
+    quat_rotate_vector(&(imu_data.q), gyro, w);
+#else
+    quat_rotate_vector(&(imu_data.q), imu_gyro, w);
+#endif
     imu_data.velocity_roll = w[0];
     imu_data.velocity_pitch = w[1];
     imu_data.velocity_yaw = w[2];
 
-    // update quaternion using mahony filter
-    mahony_update(&mahony_filter, imu_raw_data.gyro, imu_raw_data.accel);
-    imu_data.q = mahony_filter.q;
-
     // get euler angles from quaternion
     quat_to_euler(&(imu_data.q), euler);
     imu_data.angle_roll = euler[2];
     imu_data.angle_pitch = euler[1];
     imu_data.angle_yaw = euler[0];
+
+    snapshot_publish(&imu_snapshot, &imu_data);
+}
+
+// one sample per burst, IMU_USE_FIFO filters in imu_fifo_filter
+#if !IMU_USE_FIFO
+static void imu_filter_update(void)
+{
+    ImuRawData raw;
+    snapshot_read(&imu_sample_snapshot, &raw);
+
+    // sample interval
+    float32_t dt = 1.0f / mahony_filter.sample_freq;
+#if IMU_USE_DATA_READY
+    if (raw.dt >= IMU_DT_MIN && raw.dt <= IMU_DT_MAX)
+    {
+        dt = raw.dt; // otherwise first sample or a missed edge
+    }
+#endif
+
+    imu_filter_sample(&raw, dt);
+    imu_filter_publish();
+}
+#endif
+
+uint8_t imu_filter_pending(void)
+{
+    return imu_filter_due;
+}
+
+void imu_filter_run(void)
+{
+    if (!imu_filter_due)
+    {
+        return;
+    }
+    imu_filter_due = 0;
+
+#if IMU_USE_FIFO
+    imu_fifo_filter();
+#else
+    imu_filter_update();
+#endif
+}
+
+void imu_read_data(ImuData *data)
+{
+    snapshot_read(&imu_snapshot, data);
+}
+
+uint8_t imu_is_ready(void)
+{
+    return imu_ready;
+}
+
+uint8_t imu_sample_pending(void)
+{
+    return imu_dma_busy;
+}
+
+void imu_set_done_callback(void (*callback)(void))
+{
+    imu_done_callback = callback;
+}
+
+static void imu_start_burst(void)
+{
+    // previous burst is still on the bus
+    if (imu_dma_busy)
+    {
+        imu_dma_stat.overrun++;
+        return;
+    }
+    imu_dma_busy = 1;
+
+#if IMU_USE_FIFO
+    imu_fifo_start();
+#else
+    // gyro read: address, then data
+    imu_dma_tx[0] = BMI088_GYRO_X_L | 0x80;
+    SET_CS_GYRO_LOW();
+    if (SPI2_Transfer_DMA(imu_dma_tx, imu_dma_rx, IMU_GYRO_BURST_LEN, imu_gyro_burst_done) != HAL_OK)
+    {
+        imu_dma_abort();
+    }
+#endif
+}
+
+void imu_update(void)
+{
+    // sensor not configured yet
+    if (!imu_ready)
+    {
+        imu_init_step();
+        return;
+    }
+
+#if IMU_USE_HEATER
+    // every sampling mode reads the temperature at least every 100 ticks, the sensor refreshes it every 1.28 s
+    if (++imu_heater_count >= IMU_HEATER_DIVIDER)
+    {
+        imu_heater_count = 0;
+        Heater_Set_Duty(heater_update(&imu_heater, imu_raw_data.temp));
+    }
+#endif
+
+#if IMU_USE_DATA_READY
+    // sampling is driven by the sensor, the timer only watches for a silent gyro
+    if ((uint32_t)(Get_Time_us() - imu_gyro_stamp) > IMU_STALE_TIME_US)
+    {
+        imu_dma_stat.stale++;
+    }
+#else
+    imu_start_burst();
+#endif
+}
+
+void imu_gyro_data_ready(void)
+{
+    // timestamp first, the sample was latched at the edge
+    uint32_t stamp = Get_Time_us();
+    if (!imu_ready)
+    {
+        return;
+    }
+    if (imu_dma_busy)
+    {
+        imu_dma_stat.overrun++;
+        return;
+    }
+    imu_gyro_stamp = stamp;
+    imu_start_burst();
+}
+
+void imu_accel_data_ready(void)
+{
+    imu_raw_data.accel_stamp = Get_Time_us();
 }
@@ -1,5 +1,7 @@
 #include "motor.h"
+#include "snapshot.h"
 #include "bsp_fdcan.h"
+#include "bsp_tim.h"
 #include "fdcan.h"
 
 #define RPM_TO_RADS(value) ((float)(value) * 2 * 3.14159265359f / 60.0f)     // rpm to rad/s
@@ -24,20 +26,65 @@
  * global variables
  **************************************************************************
  */
-MotorInfo motors[TOTAL_MOTOR_NUM] = {
-    // CAN1 motors
-    [CHASSIS_FR] = {.type = M3508},
-    [CHASSIS_FL] = {.type = M3508},
-    [CHASSIS_BL] = {.type = M3508},
-    [CHASSIS_BR] = {.type = M3508},
-    [GIMBAL_YAW] = {.type = GM6020},
-
-    // CAN3 motors
-    [FRICTION_L] = {.type = M3508},
-    [FRICTION_R] = {.type = M3508},
-    [TRIGGER] = {.type = M2006},
-    [GIMBAL_PITCH] = {.type = GM6020},
-};
+// everything per motor below is generated from motor_topology.h
+#define MOTOR_INFO_ENTRY(index, type_, bus, rx_id, frame, slot, reduction_, zero)                                  \
+    [index] = {.type = type_, .reduction = reduction_, .zero_angle = zero},
+MotorInfo motors[TOTAL_MOTOR_NUM] = {MOTOR_TOPOLOGY(MOTOR_INFO_ENTRY)};
+
+// motors[] is the can isr working copy, tasks read the published snapshots
+static MotorInfo motor_snapshot_slot[TOTAL_MOTOR_NUM][2];
+#define MOTOR_SNAPSHOT_ENTRY(index, type, bus, rx_id, frame, slot_, reduction, zero)                               \
+    [index] = {.size = sizeof(MotorInfo), .slot = {&motor_snapshot_slot[index][0], &motor_snapshot_slot[index][1]}},
+static Snapshot motor_snapshot[TOTAL_MOTOR_NUM] = {MOTOR_TOPOLOGY(MOTOR_SNAPSHOT_ENTRY)};
+
+// where each motor's command goes, a constant table the compiler folds into the staging code
+typedef struct
+{
+    MotorType type;
+    MotorTxFrame frame;
+    uint8_t slot; // 0 ~ 3, bytes 2 * slot and 2 * slot + 1
+} MotorTxRoute;
+
+#define MOTOR_TX_ROUTE_ENTRY(index, type_, bus, rx_id, frame_, slot_, reduction, zero)                             \
+    [index] = {.type = type_, .frame = frame_, .slot = slot_},
+static const MotorTxRoute motor_tx_route[TOTAL_MOTOR_NUM] = {MOTOR_TOPOLOGY(MOTOR_TX_ROUTE_ENTRY)};
+
+// four commands per frame, a wrong slot fails the build
+#define MOTOR_SLOT_CHECK(index, type, bus, rx_id, frame, slot, reduction, zero)                                    \
+    _Static_assert((slot) < 4, #index " command slot out of range");
+MOTOR_TOPOLOGY(MOTOR_SLOT_CHECK)
+
+// one bit per (frame, slot), the sum of the rows equals their or only when no two rows share a slot
+#define MOTOR_SLOT_BIT(index, type, bus, rx_id, frame, slot, reduction, zero) (1ULL << ((frame) * 4 + (slot)))
+#define MOTOR_SLOT_SUM(...) +MOTOR_SLOT_BIT(__VA_ARGS__)
+#define MOTOR_SLOT_OR(...) | MOTOR_SLOT_BIT(__VA_ARGS__)
+_Static_assert(MOTOR_TX_NUM * 4 <= 64, "command slots do not fit the uniqueness mask");
+_Static_assert((0 MOTOR_TOPOLOGY(MOTOR_SLOT_SUM)) == (0 MOTOR_TOPOLOGY(MOTOR_SLOT_OR)),
+               "two motors share a command frame slot");
+
+// command staging, the control tasks write here and motor_flush_commands puts it on the bus
+typedef struct
+{
+    FDCAN_HandleTypeDef *hfdcan;
+    uint32_t std_id;
+    uint8_t data[8]; // slots keep their last command, a slot never commanded stays 0
+    uint8_t pending; // staged, not yet accepted by the tx fifo
+    uint8_t waited;  // flushes the pending frame has been held back
+} MotorTxSlot;
+
+#define MOTOR_BUS_HANDLE(bus) ((bus) == MOTOR_CAN1 ? &hfdcan1 : &hfdcan3)
+#define MOTOR_TX_SLOT_ENTRY(frame, bus, id) [frame] = {.hfdcan = MOTOR_BUS_HANDLE(bus), .std_id = (id)},
+static MotorTxSlot motor_tx_slot[MOTOR_TX_NUM] = {MOTOR_TX_TOPOLOGY(MOTOR_TX_SLOT_ENTRY)};
+
+MotorTxStat motor_tx_stat[MOTOR_TX_NUM];
+
+// feedback link health, updated by motor_data_interpret
+MotorLinkStat motor_link_stat[TOTAL_MOTOR_NUM];
+
+// velocity observers, updated by motor_data_interpret, ready without motor_init
+#define MOTOR_PLL_ENTRY(index, type, bus, rx_id, frame, slot, reduction, zero)                                     \
+    [index] = PLL_INIT(PLL_JERK_NOISE),
+static PllInfo motor_pll[TOTAL_MOTOR_NUM] = {MOTOR_TOPOLOGY(MOTOR_PLL_ENTRY)};
 
 /*
  **************************************************************************
@@ -54,6 +101,90 @@ void reset_motor_info(MotorInfo *motor)
     motor->angle = 0.0f;
     motor->velocity = 0.0f;
     motor->current = 0.0f;
+    motor->angle_est = 0.0f;
+    motor->velocity_est = 0.0f;
+    motor->turns = 0;
+    motor->total_angle = 0.0f;
+    motor->output_angle = 0.0f;
+    motor->zero_offset = 0.0f;
+    motor->stamp = 0;
+    motor->seq = 0;
+    motor->rate = 0.0f;
+    motor->rate_start = 0;
+    motor->rate_seq = 0;
+}
+
+// count rotor turns from the raw angle step, a frame moves the rotor far less than half a turn at any speed,
+// frames lost while the rotor spins fast lose turns
+static void motor_turn_update(MotorInfo *motor, uint16_t raw_angle_last)
+{
+    int32_t half = MOTOR_ENCODER_COUNTS / 2;
+    if (motor->seq == 0)
+    {
+        // first frame: the turn that puts the angle within half a turn of the zero
+        int32_t offset = (int32_t)motor->raw_angle - motor->zero_angle;
+        motor->turns = (offset >= half) ? -1 : (offset < -half) ? 1 : 0;
+    }
+    else
+    {
+        int32_t step = (int32_t)motor->raw_angle - raw_angle_last;
+        if (step > half)
+        {
+            motor->turns--;
+        }
+        else if (step < -half)
+        {
+            motor->turns++;
+        }
+    }
+
+    // whole turns and the sub-turn count converted apart, turns * counts would overflow int32 past 262144 turns
+    int32_t counts = (int32_t)motor->raw_angle - motor->zero_angle;
+    motor->total_angle = (float)motor->turns * ANGLE_TO_RADS(MOTOR_ENCODER_COUNTS) + ANGLE_TO_RADS(counts);
+    motor->output_angle = motor->reduction > 0.0f ? motor->total_angle / motor->reduction : motor->total_angle;
+
+    // wrapped in counts, total_angle loses resolution as the turns grow
+    if (counts >= half)
+    {
+        counts -= MOTOR_ENCODER_COUNTS;
+    }
+    else if (counts < -half)
+    {
+        counts += MOTOR_ENCODER_COUNTS;
+    }
+    motor->zero_offset = ANGLE_TO_RADS(counts);
+}
+
+static void motor_link_update(MotorInfo *motor, uint32_t now)
+{
+    MotorLinkStat *link = &motor_link_stat[motor - motors];
+
+    if (motor->seq > 0)
+    {
+        uint32_t gap = now - motor->stamp;
+        if (gap > link->gap_max)
+        {
+            link->gap_max = gap;
+        }
+        if (gap > MOTOR_OFFLINE_US)
+        {
+            link->dropouts++;
+        }
+    }
+    else
+    {
+        motor->rate_start = now;
+        motor->rate_seq = 0;
+    }
+
+    // frame rate over a fixed window, published with the frame
+    uint32_t window = now - motor->rate_start;
+    if (window >= MOTOR_RATE_WINDOW_US)
+    {
+        motor->rate = (motor->seq + 1 - motor->rate_seq) * 1.0e6f / window;
+        motor->rate_start = now;
+        motor->rate_seq = motor->seq + 1;
+    }
 }
 
 void motor_init(void)
@@ -61,11 +192,15 @@ void motor_init(void)
     for (int i = 0; i < TOTAL_MOTOR_NUM; i++)
     {
         reset_motor_info(&motors[i]);
+        pll_init(&motor_pll[i], PLL_JERK_NOISE);
     }
 }
 
 void motor_data_interpret(uint8_t *buff, MotorInfo *motor)
 {
+    uint32_t now = Get_Time_us();
+    uint16_t raw_angle_last = motor->raw_angle;
+
     // interpret feedback raw data
     motor->raw_angle = (buff[0] << 8) | buff[1];
     motor->raw_velocity = (buff[2] << 8) | buff[3];
@@ -89,6 +224,141 @@ void motor_data_interpret(uint8_t *buff, MotorInfo *motor)
     default:
         break;
     }
+
+    // stamp and publish a coherent copy for the control tasks
+    if (motor >= motors && motor < motors + TOTAL_MOTOR_NUM)
+    {
+        // the first frame and frames after a dropout relock the observer
+        PllInfo *pll = &motor_pll[motor - motors];
+        pll_update(pll, motor->angle, motor->velocity, (now - motor->stamp) * 1.0e-6f);
+        motor->angle_est = pll->angle;
+        motor->velocity_est = pll->velocity;
+
+        motor_turn_update(motor, raw_angle_last);
+
+        motor_link_update(motor, now);
+        motor->stamp = now;
+        motor->seq++;
+        snapshot_publish(&motor_snapshot[motor - motors], motor);
+    }
+}
+
+void motor_get_info(Motor_Index index, MotorInfo *info)
+{
+    snapshot_read(&motor_snapshot[index], info);
+}
+
+uint8_t motor_is_online(Motor_Index index)
+{
+    MotorInfo info;
+    snapshot_read(&motor_snapshot[index], &info);
+    return info.seq > 0 && motor_age_us(&info) < MOTOR_OFFLINE_US;
+}
+
+uint32_t motor_age_us(const MotorInfo *info)
+{
+    return Get_Time_us() - info->stamp;
+}
+
+float motor_rate_hz(const MotorInfo *info)
+{
+    // a window no frame has closed yet is averaged up to now, so the rate falls while the frames stop,
+    // and a whole window without any frame is 0
+    uint32_t now = Get_Time_us();
+    uint32_t window = now - info->rate_start;
+    if (info->seq == 0 || now - info->stamp >= MOTOR_RATE_WINDOW_US)
+    {
+        return 0.0f;
+    }
+    if (window < MOTOR_RATE_WINDOW_US)
+    {
+        return info->rate;
+    }
+    return (info->seq - info->rate_seq) * 1.0e6f / window;
+}
+
+/*
+ **************************************************************************
+ * command staging
+ **************************************************************************
+ */
+static void motor_stage_frame(MotorTxFrame frame)
+{
+    MotorTxSlot *slot = &motor_tx_slot[frame];
+
+    // the previous command never made it to the bus
+    if (slot->pending)
+    {
+        motor_tx_stat[frame].dropped++;
+    }
+
+    slot->pending = 1;
+    slot->waited = 0;
+}
+
+// scale each command for its esc, write it into its slot, then stage every frame that was touched
+static void motor_stage_commands(const Motor_Index *index, const float *command, int num)
+{
+    uint32_t frames = 0;
+
+    for (int i = 0; i < num; i++)
+    {
+        const MotorTxRoute *route = &motor_tx_route[index[i]];
+        int16_t value;
+        switch (route->type)
+        {
+        case M3508:
+            value = M3508_CURRENT_FLOAT_TO_INT(command[i]);
+            break;
+        case M2006:
+            value = M2006_CURRENT_FLOAT_TO_INT(command[i]);
+            break;
+        case GM6020:
+        default:
+            value = GM6020_VOLTAGE_FLOAT_TO_INT(command[i]);
+            break;
+        }
+
+        uint8_t *data = &motor_tx_slot[route->frame].data[2 * route->slot];
+        data[0] = (value >> 8) & 0xFF;
+        data[1] = value & 0xFF;
+        frames |= 1u << route->frame;
+    }
+
+    for (int i = 0; i < MOTOR_TX_NUM; i++)
+    {
+        if (frames & (1u << i))
+        {
+            motor_stage_frame((MotorTxFrame)i);
+        }
+    }
+}
+
+void motor_flush_commands(void)
+{
+    for (int i = 0; i < MOTOR_TX_NUM; i++)
+    {
+        MotorTxSlot *slot = &motor_tx_slot[i];
+        if (!slot->pending)
+        {
+            continue;
+        }
+
+        // tx fifo full: keep the frame, the next flush retries it or a newer command replaces it
+        if (BSP_FDCAN_TxMessage(slot->hfdcan, slot->std_id, slot->data) != HAL_OK)
+        {
+            motor_tx_stat[i].fifo_full++;
+            slot->waited++;
+            continue;
+        }
+
+        if (slot->waited)
+        {
+            motor_tx_stat[i].late++;
+        }
+        motor_tx_stat[i].sent++;
+        slot->pending = 0;
+    }
 }
 
 /*
@@ -99,62 +369,23 @@ void motor_data_interpret(uint8_t *buff, MotorInfo *motor)
 void motor_set_body_current(float c_fr, float c_fl, float c_bl, float c_br)
 {
     // current command: front right, front left, back left, back right
-    // convert float command into int
-    int16_t c_fr_int = M3508_CURRENT_FLOAT_TO_INT(c_fr);
-    int16_t c_fl_int = M3508_CURRENT_FLOAT_TO_INT(c_fl);
-    int16_t c_bl_int = M3508_CURRENT_FLOAT_TO_INT(c_bl);
-    int16_t c_br_int = M3508_CURRENT_FLOAT_TO_INT(c_br);
-
-    // prepare data
-    uint8_t data[8] = {0};
-    data[0] = (c_fr_int >> 8) & 0xFF;
-    data[1] = c_fr_int & 0xFF;
-    data[2] = (c_fl_int >> 8) & 0xFF;
-    data[3] = c_fl_int & 0xFF;
-    data[4] = (c_bl_int >> 8) & 0xFF;
-    data[5] = c_bl_int & 0xFF;
-    data[6] = (c_br_int >> 8) & 0xFF;
-    data[7] = c_br_int & 0xFF;
-
-    // send command message
-    BSP_FDCAN_TxMessage(&hfdcan1, 0x200, data);
+    static const Motor_Index index[] = {CHASSIS_FR, CHASSIS_FL, CHASSIS_BL, CHASSIS_BR};
+    float command[] = {c_fr, c_fl, c_bl, c_br};
+    motor_stage_commands(index, command, 4);
 }
 
 void motor_set_neck_voltage(float v_yaw)
 {
     // voltage command: gimbal yaw
-    // convert float command into int
-    int16_t v_yaw_int = GM6020_VOLTAGE_FLOAT_TO_INT(v_yaw);
-
-    // prepare data
-    uint8_t data[8] = {0};
-    data[0] = (v_yaw_int >> 8) & 0xFF;
-    data[1] = v_yaw_int & 0xFF;
-
-    // send command message
-    BSP_FDCAN_TxMessage(&hfdcan1, 0x2FF, data);
+    static const Motor_Index index[] = {GIMBAL_YAW};
+    float command[] = {v_yaw};
+    motor_stage_commands(index, command, 1);
 }
 
 void motor_set_head_command(float v_pitch, float c_friction_left, float c_friction_right, float v_trigger)
 {
     // command: gimbal pitch voltage, friction left current, friction right current, trigger current
-    // convert float command into int
-    int16_t v_pitch_int = GM6020_VOLTAGE_FLOAT_TO_INT(v_pitch);
-    int16_t c_friction_left_int = M3508_CURRENT_FLOAT_TO_INT(c_friction_left);
-    int16_t c_friction_right_int = M3508_CURRENT_FLOAT_TO_INT(c_friction_right);
-    int16_t c_trigger_int = M2006_CURRENT_FLOAT_TO_INT(v_trigger);
-
-    // prepare data
-    uint8_t data[8] = {0};
-    data[0] = (v_pitch_int >> 8) & 0xFF;
-    data[1] = v_pitch_int & 0xFF;
-    data[2] = (c_friction_left_int >> 8) & 0xFF;
-    data[3] = c_friction_left_int & 0xFF;
-    data[4] = (c_friction_right_int >> 8) & 0xFF;
-    data[5] = c_friction_right_int & 0xFF;
-    data[6] = (c_trigger_int >> 8) & 0xFF;
-    data[7] = c_trigger_int & 0xFF;
-
-    // send command message
-    BSP_FDCAN_TxMessage(&hfdcan3, 0x1FF, data);
+    static const Motor_Index index[] = {GIMBAL_PITCH, FRICTION_L, FRICTION_R, TRIGGER};
+    float command[] = {v_pitch, c_friction_left, c_friction_right, v_trigger};
+    motor_stage_commands(index, command, 4);
 }
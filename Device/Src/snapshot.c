@@ -0,0 +1,61 @@
+#include <string.h>
+#include "snapshot.h"
+
+// compiles to dmb on the cortex-m7, keeps the slot copy and the seq update ordered
+#define SNAPSHOT_BARRIER() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+/*
+ **************************************************************************
+ * writer side
+ **************************************************************************
+ */
+void *snapshot_write_begin(Snapshot *snap)
+{
+    // mark the slot before the first byte changes
+    uint32_t index = (snap->seq + 1) & 1;
+    snap->gen[index] = snap->gen[index] + 1;
+    SNAPSHOT_BARRIER();
+    return snap->slot[index];
+}
+
+void snapshot_write_end(Snapshot *snap)
+{
+    // slot content must be visible before its generation and the new seq
+    uint32_t index = (snap->seq + 1) & 1;
+    SNAPSHOT_BARRIER();
+    snap->gen[index] = snap->gen[index] + 1;
+    snap->seq = snap->seq + 1;
+    SNAPSHOT_BARRIER();
+}
+
+void snapshot_publish(Snapshot *snap, const void *data)
+{
+    memcpy(snapshot_write_begin(snap), data, snap->size);
+    snapshot_write_end(snap);
+}
+
+/*
+ **************************************************************************
+ * reader side
+ **************************************************************************
+ */
+uint32_t snapshot_read(Snapshot *snap, void *out)
+{
+    uint32_t seq, gen_begin, gen_end;
+
+    do
+    {
+        seq = snap->seq;
+        uint32_t index = seq & 1;
+        SNAPSHOT_BARRIER();
+        gen_begin = snap->gen[index];
+        SNAPSHOT_BARRIER();
+        memcpy(out, snap->slot[index], snap->size);
+        SNAPSHOT_BARRIER();
+        gen_end = snap->gen[index];
+
+        // the writer came back to our slot, still filling it or done since: the copy may be mixed
+    } while ((gen_begin & 1) != 0 || gen_end != gen_begin);
+
+    return seq;
+}
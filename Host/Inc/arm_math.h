@@ -0,0 +1,54 @@
+#ifndef __HOST_ARM_MATH_H__
+#define __HOST_ARM_MATH_H__
+
+/*
+ * host-side stand-in for CMSIS-DSP arm_math.h
+ * only the functions used by Algorithm/ and Application/ are provided,
+ * with the same signatures and corner-case behaviour as CMSIS-DSP
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#ifndef PI
+#define PI (3.14159265358979f)
+#endif
+
+typedef float float32_t;
+typedef double float64_t;
+
+typedef enum
+{
+    ARM_MATH_SUCCESS = 0,
+    ARM_MATH_ARGUMENT_ERROR = -1,
+    ARM_MATH_LENGTH_ERROR = -2,
+    ARM_MATH_SIZE_MISMATCH = -3,
+    ARM_MATH_NANINF = -4,
+    ARM_MATH_SINGULAR = -5,
+    ARM_MATH_TEST_FAILURE = -6
+} arm_status;
+
+// matrix instance, row major
+typedef struct
+{
+    uint16_t numRows;
+    uint16_t numCols;
+    float32_t *pData;
+} arm_matrix_instance_f32;
+
+// fast math functions
+float32_t arm_sin_f32(float32_t x);
+float32_t arm_cos_f32(float32_t x);
+void arm_sin_cos_f32(float32_t theta, float32_t *pSinVal, float32_t *pCosVal); // theta in degrees
+arm_status arm_sqrt_f32(float32_t in, float32_t *pOut);
+
+// basic vector functions
+void arm_dot_prod_f32(const float32_t *pSrcA, const float32_t *pSrcB, uint32_t blockSize, float32_t *result);
+
+// matrix functions
+void arm_mat_init_f32(arm_matrix_instance_f32 *S, uint16_t nRows, uint16_t nColumns, float32_t *pData);
+arm_status arm_mat_mult_f32(const arm_matrix_instance_f32 *pSrcA, const arm_matrix_instance_f32 *pSrcB,
+                            arm_matrix_instance_f32 *pDst);
+
+#endif // __HOST_ARM_MATH_H__
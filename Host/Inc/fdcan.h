@@ -0,0 +1,19 @@
+#ifndef __HOST_FDCAN_H__
+#define __HOST_FDCAN_H__
+
+/*
+ * host-side stand-in for Core/Inc/fdcan.h
+ * a handle only carries the bus number, transmitted frames are recorded by host_can
+ */
+
+#include "main.h"
+
+typedef struct
+{
+    uint8_t bus; // 1: FDCAN1, 3: FDCAN3
+} FDCAN_HandleTypeDef;
+
+extern FDCAN_HandleTypeDef hfdcan1;
+extern FDCAN_HandleTypeDef hfdcan3;
+
+#endif // __HOST_FDCAN_H__
@@ -0,0 +1,27 @@
+#ifndef __HOST_CAN_H__
+#define __HOST_CAN_H__
+
+#include <stdint.h>
+#include "fdcan.h"
+
+#define HOST_CAN_LOG_SIZE 256 // recorded frames kept, oldest are overwritten
+
+typedef struct
+{
+    uint8_t bus;      // 1 or 3
+    uint32_t std_id;  // standard identifier
+    uint8_t data[8];  // dji-can always use 8 bytes
+    uint32_t tick;    // HAL_GetTick() at transmission
+} HostCanFrame;
+
+// called on every transmitted frame, e.g. to feed a plant model
+typedef void (*HostCanTxHook)(const HostCanFrame *frame);
+void host_can_set_tx_hook(HostCanTxHook hook);
+
+// recorded tx frames
+void host_can_clear(void);
+uint32_t host_can_frame_count(void);                // total frames since last clear
+const HostCanFrame *host_can_get_frame(uint32_t n); // n = 0 is the oldest kept frame
+const HostCanFrame *host_can_last_frame(uint8_t bus, uint32_t std_id);
+
+#endif // __HOST_CAN_H__
@@ -0,0 +1,27 @@
+#ifndef __HOST_MAIN_H__
+#define __HOST_MAIN_H__
+
+/*
+ * host-side stand-in for Core/Inc/main.h
+ * provides the small part of the HAL that Device/ and Application/ touch
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef enum
+{
+    HAL_OK = 0x00U,
+    HAL_ERROR = 0x01U,
+    HAL_BUSY = 0x02U,
+    HAL_TIMEOUT = 0x03U
+} HAL_StatusTypeDef;
+
+uint32_t HAL_GetTick(void);
+void Error_Handler(void);
+
+// host tick control, 1 tick = 1 ms as on the board
+void host_set_tick(uint32_t tick);
+void host_advance_tick(uint32_t ms);
+
+#endif // __HOST_MAIN_H__
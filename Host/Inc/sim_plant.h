@@ -0,0 +1,67 @@
+#ifndef __SIM_PLANT_H__
+#define __SIM_PLANT_H__
+
+#include <stdint.h>
+#include "motor.h"
+
+/*
+ * rigid-body plant for the 9 motors in motors[TOTAL_MOTOR_NUM]
+ * commands are taken from the transmitted can frames (0x200 / 0x2FF on can1, 0x1FF on can3),
+ * feedback is pushed back through motor_data_interpret in the esc frame format
+ * imu_read_data / imu_is_ready of imu.c are served from the chassis state
+ */
+
+typedef struct
+{
+    // physical parameters, rotor side
+    float inertia;       // kg m^2, rotor + reflected load
+    float kt;            // N m / A, rotor torque constant (= back emf constant)
+    float resistance;    // ohm, phase resistance
+    float inductance;    // H, only used by voltage driven motors
+    float damping;       // N m s / rad, viscous friction
+    float coulomb;       // N m, dry friction
+    float current_limit; // A, esc current limit
+    float current_tau;   // s, esc current loop time constant
+    uint16_t encoder_offset; // raw angle reported at angle = 0
+
+    // state
+    float command;  // A for current driven motors, V for GM6020
+    float current;  // A
+    float velocity; // rad/s, rotor
+    float angle;    // rad, rotor, unwrapped
+} SimRotor;
+
+typedef struct
+{
+    SimRotor rotor[TOTAL_MOTOR_NUM];
+
+    // omni chassis, chassis frame, +x forward, +y left
+    float chassis_mass;    // kg
+    float chassis_inertia; // kg m^2
+    float chassis_half;    // m, wheel offset from centre along x and y
+    float chassis_v[3];    // vx (m/s), vy (m/s), wz (rad/s)
+    float chassis_yaw;     // rad, world frame
+
+    // gimbal, world frame yaw = chassis yaw + yaw motor angle
+    float gimbal_yaw;      // rad, world frame
+    float gimbal_yaw_rate; // rad/s, world frame
+    float pitch_gravity;   // N m, unbalanced pitch torque at level
+    float pitch_limit[2];  // rad, mechanical stops (min, max)
+
+    float supply_voltage; // V
+    float time;           // s
+} SimPlant;
+
+void sim_plant_init(void);
+void sim_plant_step(float dt);
+void sim_plant_send_feedback(void);
+
+// handy measurements
+float sim_plant_yaw_angle(void);   // rad, yaw motor relative to the forward angle
+float sim_plant_pitch_angle(void); // rad, pitch motor relative to level
+float sim_plant_wheel_power(void); // W, electrical power of the four chassis motors
+
+// global variables
+extern SimPlant sim_plant;
+
+#endif // __SIM_PLANT_H__
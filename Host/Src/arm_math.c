@@ -0,0 +1,86 @@
+#include "arm_math.h"
+
+/*
+ **************************************************************************
+ * fast math functions
+ **************************************************************************
+ */
+float32_t arm_sin_f32(float32_t x)
+{
+    return sinf(x);
+}
+
+float32_t arm_cos_f32(float32_t x)
+{
+    return cosf(x);
+}
+
+void arm_sin_cos_f32(float32_t theta, float32_t *pSinVal, float32_t *pCosVal)
+{
+    // cmsis takes the angle in degrees here, keep it that way
+    float32_t rad = theta * (PI / 180.0f);
+    *pSinVal = sinf(rad);
+    *pCosVal = cosf(rad);
+}
+
+arm_status arm_sqrt_f32(float32_t in, float32_t *pOut)
+{
+    if (in >= 0.0f)
+    {
+        *pOut = sqrtf(in);
+        return ARM_MATH_SUCCESS;
+    }
+    *pOut = 0.0f;
+    return ARM_MATH_ARGUMENT_ERROR;
+}
+
+/*
+ **************************************************************************
+ * basic vector functions
+ **************************************************************************
+ */
+void arm_dot_prod_f32(const float32_t *pSrcA, const float32_t *pSrcB, uint32_t blockSize, float32_t *result)
+{
+    float32_t sum = 0.0f;
+    for (uint32_t i = 0; i < blockSize; i++)
+    {
+        sum += pSrcA[i] * pSrcB[i];
+    }
+    *result = sum;
+}
+
+/*
+ **************************************************************************
+ * matrix functions
+ **************************************************************************
+ */
+void arm_mat_init_f32(arm_matrix_instance_f32 *S, uint16_t nRows, uint16_t nColumns, float32_t *pData)
+{
+    S->numRows = nRows;
+    S->numCols = nColumns;
+    S->pData = pData;
+}
+
+arm_status arm_mat_mult_f32(const arm_matrix_instance_f32 *pSrcA, const arm_matrix_instance_f32 *pSrcB,
+                            arm_matrix_instance_f32 *pDst)
+{
+    // cmsis only checks the sizes with ARM_MATH_MATRIX_CHECK, the host always does
+    if (pSrcA->numCols != pSrcB->numRows || pSrcA->numRows != pDst->numRows || pSrcB->numCols != pDst->numCols)
+    {
+        return ARM_MATH_SIZE_MISMATCH;
+    }
+
+    for (uint16_t i = 0; i < pSrcA->numRows; i++)
+    {
+        for (uint16_t j = 0; j < pSrcB->numCols; j++)
+        {
+            float32_t sum = 0.0f;
+            for (uint16_t k = 0; k < pSrcA->numCols; k++)
+            {
+                sum += pSrcA->pData[i * pSrcA->numCols + k] * pSrcB->pData[k * pSrcB->numCols + j];
+            }
+            pDst->pData[i * pDst->numCols + j] = sum;
+        }
+    }
+    return ARM_MATH_SUCCESS;
+}
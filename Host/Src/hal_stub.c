@@ -0,0 +1,115 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "main.h"
+#include "fdcan.h"
+#include "bsp_fdcan.h"
+#include "bsp_tim.h"
+#include "host_can.h"
+
+/*
+ **************************************************************************
+ * global variables
+ **************************************************************************
+ */
+FDCAN_HandleTypeDef hfdcan1 = {.bus = 1};
+FDCAN_HandleTypeDef hfdcan3 = {.bus = 3};
+
+static uint32_t host_tick;
+
+static HostCanFrame can_log[HOST_CAN_LOG_SIZE];
+static uint32_t can_log_count;
+static HostCanTxHook can_tx_hook;
+
+/*
+ **************************************************************************
+ * hal tick and error handler
+ **************************************************************************
+ */
+uint32_t HAL_GetTick(void)
+{
+    return host_tick;
+}
+
+void host_set_tick(uint32_t tick)
+{
+    host_tick = tick;
+}
+
+void host_advance_tick(uint32_t ms)
+{
+    host_tick += ms;
+}
+
+uint32_t Get_Time_us(void)
+{
+    return host_tick * 1000;
+}
+
+void Error_Handler(void)
+{
+    fprintf(stderr, "Error_Handler called\n");
+    abort();
+}
+
+/*
+ **************************************************************************
+ * fdcan transmit recording
+ **************************************************************************
+ */
+HAL_StatusTypeDef BSP_FDCAN_TxMessage(FDCAN_HandleTypeDef *hfdcan, uint32_t StdId, uint8_t *pData)
+{
+    HostCanFrame *frame = &can_log[can_log_count % HOST_CAN_LOG_SIZE];
+
+    frame->bus = hfdcan->bus;
+    frame->std_id = StdId;
+    memcpy(frame->data, pData, 8);
+    frame->tick = host_tick;
+    can_log_count++;
+
+    if (can_tx_hook != NULL)
+    {
+        can_tx_hook(frame);
+    }
+
+    return HAL_OK;
+}
+
+void host_can_set_tx_hook(HostCanTxHook hook)
+{
+    can_tx_hook = hook;
+}
+
+void host_can_clear(void)
+{
+    can_log_count = 0;
+}
+
+uint32_t host_can_frame_count(void)
+{
+    return can_log_count;
+}
+
+const HostCanFrame *host_can_get_frame(uint32_t n)
+{
+    uint32_t kept = can_log_count < HOST_CAN_LOG_SIZE ? can_log_count : HOST_CAN_LOG_SIZE;
+    if (n >= kept)
+    {
+        return NULL;
+    }
+    return &can_log[(can_log_count - kept + n) % HOST_CAN_LOG_SIZE];
+}
+
+const HostCanFrame *host_can_last_frame(uint8_t bus, uint32_t std_id)
+{
+    uint32_t kept = can_log_count < HOST_CAN_LOG_SIZE ? can_log_count : HOST_CAN_LOG_SIZE;
+    for (uint32_t i = 0; i < kept; i++)
+    {
+        const HostCanFrame *frame = &can_log[(can_log_count - 1 - i) % HOST_CAN_LOG_SIZE];
+        if (frame->bus == bus && frame->std_id == std_id)
+        {
+            return frame;
+        }
+    }
+    return NULL;
+}
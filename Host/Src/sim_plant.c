@@ -0,0 +1,443 @@
+#include <math.h>
+#include <string.h>
+#include "sim_plant.h"
+#include "host_can.h"
+#include "imu.h"
+
+#ifndef PI
+#define PI (3.14159265358979f)
+#endif
+
+#define M3508_GEAR_RATIO (3591.0f / 187.0f)
+#define WHEEL_RADIUS (0.10f) // m, as chassis_geometry in body.c
+
+#define SIM_ENCODER_COUNTS (8192.0f)
+#define SIM_TEMPERATURE (30)
+#define SIM_COULOMB_SMOOTH (0.05f) // rad/s, dry friction smoothing band
+
+// esc command scaling, inverse of motor.c
+#define M3508_CURRENT_INT_TO_FLOAT(value) ((float)(value) * 20.0f / 16384.0f)
+#define M2006_CURRENT_INT_TO_FLOAT(value) ((float)(value) * 10.0f / 10000.0f)
+#define GM6020_VOLTAGE_INT_TO_FLOAT(value) ((float)(value) * 24.0f / 25000.0f)
+
+// esc feedback scaling, inverse of motor.c
+#define M3508_CURRENT_FLOAT_TO_INT(value) ((int16_t)((value) * 16384.0f / 20.0f))
+#define M2006_CURRENT_FLOAT_TO_INT(value) ((int16_t)((value) * 10000.0f / 10.0f))
+#define GM6020_CURRENT_FLOAT_TO_INT(value) ((int16_t)((value) * 16384.0f / 3.0f))
+
+/*
+ **************************************************************************
+ * parameters
+ **************************************************************************
+ */
+// datasheet values where available, inertia and friction are estimates
+static const SimRotor M3508_WHEEL = {
+    .inertia = 2.1e-5f, // rotor + omni wheel reflected through 19.2:1
+    .kt = 0.3f / M3508_GEAR_RATIO,
+    .resistance = 0.194f,
+    .damping = 2.0e-6f,
+    .coulomb = 2.0e-3f,
+    .current_limit = 20.0f,
+    .current_tau = 0.5e-3f,
+};
+
+static const SimRotor M3508_FRICTION = {
+    .inertia = 1.2e-4f, // gearbox removed, rotor + friction wheel
+    .kt = 0.3f / M3508_GEAR_RATIO,
+    .resistance = 0.194f,
+    .damping = 1.0e-5f,
+    .coulomb = 2.0e-3f,
+    .current_limit = 20.0f,
+    .current_tau = 0.5e-3f,
+};
+
+static const SimRotor M2006_TRIGGER = {
+    .inertia = 2.5e-6f, // rotor + trigger disk reflected through 36:1
+    .kt = 0.18f / 36.0f,
+    .resistance = 0.5f,
+    .damping = 1.0e-6f,
+    .coulomb = 1.0e-3f,
+    .current_limit = 10.0f,
+    .current_tau = 0.5e-3f,
+};
+
+static const SimRotor GM6020_YAW = {
+    .inertia = 0.04f, // whole gimbal around yaw
+    .kt = 0.741f,
+    .resistance = 1.8f,
+    .inductance = 5.76e-3f,
+    .damping = 0.02f, // slip ring and bearing
+    .coulomb = 0.02f,
+    .current_limit = 3.0f,
+    .encoder_offset = 3406, // RIGHT_FORWARD_ANGLE in neck.c
+};
+
+static const SimRotor GM6020_PITCH = {
+    .inertia = 0.02f,
+    .kt = 0.741f,
+    .resistance = 1.8f,
+    .inductance = 5.76e-3f,
+    .damping = 0.01f,
+    .coulomb = 0.02f,
+    .current_limit = 3.0f,
+    .encoder_offset = 1430, // level position in head.c
+};
+
+// omni-x wheel layout, matches kinematics.c and the chassis_geometry signs in body.c
+// positive rotor speed drives the wheel contact point along sign * dir
+static const float wheel_pos[4][2] = {{1.0f, -1.0f}, {1.0f, 1.0f}, {-1.0f, 1.0f}, {-1.0f, -1.0f}};
+static const float wheel_dir[4][2] = {{1.0f, 1.0f}, {1.0f, -1.0f}, {1.0f, 1.0f}, {1.0f, -1.0f}};
+static const float wheel_sign[4] = {-1.0f, 1.0f, 1.0f, -1.0f};
+
+/*
+ **************************************************************************
+ * global variables
+ **************************************************************************
+ */
+SimPlant sim_plant;
+
+static float wheel_jacobian[4][3]; // rotor speed = jacobian * (vx, vy, wz)
+
+/*
+ **************************************************************************
+ * helper functions
+ **************************************************************************
+ */
+static inline float val_limit_float(float x, float min, float max)
+{
+    if (x > max)
+    {
+        return max;
+    }
+    else if (x < min)
+    {
+        return min;
+    }
+    return x;
+}
+
+static inline int16_t read_int16(const uint8_t *buff)
+{
+    return (int16_t)((buff[0] << 8) | buff[1]);
+}
+
+static inline void write_int16(uint8_t *buff, int16_t value)
+{
+    buff[0] = ((uint16_t)value >> 8) & 0xFF;
+    buff[1] = (uint16_t)value & 0xFF;
+}
+
+// rotor shaft torque after friction
+static inline float rotor_torque(SimRotor *rotor)
+{
+    return rotor->kt * rotor->current - rotor->damping * rotor->velocity -
+           rotor->coulomb * tanhf(rotor->velocity / SIM_COULOMB_SMOOTH);
+}
+
+// esc current loop, saturated by the supply voltage minus back emf
+static void current_driven_update(SimRotor *rotor, float dt)
+{
+    float back_emf = rotor->kt * rotor->velocity;
+    float i_max = (sim_plant.supply_voltage - back_emf) / rotor->resistance;
+    float i_min = (-sim_plant.supply_voltage - back_emf) / rotor->resistance;
+
+    float target = val_limit_float(rotor->command, -rotor->current_limit, rotor->current_limit);
+    target = val_limit_float(target, i_min, i_max);
+    rotor->current += (target - rotor->current) * (1.0f - expf(-dt / rotor->current_tau));
+}
+
+// gm6020 in voltage mode, exact solution of L di/dt = V - R i - ke w over dt
+static void voltage_driven_update(SimRotor *rotor, float dt)
+{
+    float voltage = val_limit_float(rotor->command, -sim_plant.supply_voltage, sim_plant.supply_voltage);
+    float i_steady = (voltage - rotor->kt * rotor->velocity) / rotor->resistance;
+    float decay = expf(-dt * rotor->resistance / rotor->inductance);
+    rotor->current = i_steady + (rotor->current - i_steady) * decay;
+    rotor->current = val_limit_float(rotor->current, -rotor->current_limit, rotor->current_limit);
+}
+
+static void free_rotor_update(SimRotor *rotor, float external_torque, float dt)
+{
+    rotor->velocity += (rotor_torque(rotor) + external_torque) / rotor->inertia * dt;
+    rotor->angle += rotor->velocity * dt;
+}
+
+// solve a x = b for a 3x3 system, cramer's rule
+static void solve_3x3(float a[3][3], float b[3], float x[3])
+{
+    float det = a[0][0] * (a[1][1] * a[2][2] - a[1][2] * a[2][1]) -
+                a[0][1] * (a[1][0] * a[2][2] - a[1][2] * a[2][0]) +
+                a[0][2] * (a[1][0] * a[2][1] - a[1][1] * a[2][0]);
+    for (int k = 0; k < 3; k++)
+    {
+        float m[3][3];
+        memcpy(m, a, sizeof(m));
+        for (int r = 0; r < 3; r++)
+        {
+            m[r][k] = b[r];
+        }
+        x[k] = (m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) -
+                m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+                m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0])) /
+               det;
+    }
+}
+
+/*
+ **************************************************************************
+ * plant dynamics
+ **************************************************************************
+ */
+static void chassis_update(float dt)
+{
+    // mass matrix: chassis body + rotor inertia seen through the no-slip constraint
+    float mass[3][3] = {
+        {sim_plant.chassis_mass, 0.0f, 0.0f},
+        {0.0f, sim_plant.chassis_mass, 0.0f},
+        {0.0f, 0.0f, sim_plant.chassis_inertia}};
+    float force[3];
+    float *v = sim_plant.chassis_v;
+
+    // coriolis terms, velocities are in the rotating chassis frame
+    force[0] = sim_plant.chassis_mass * v[2] * v[1];
+    force[1] = -sim_plant.chassis_mass * v[2] * v[0];
+    force[2] = 0.0f;
+
+    for (int i = 0; i < 4; i++)
+    {
+        SimRotor *rotor = &sim_plant.rotor[CHASSIS_FR + i];
+        float torque = rotor_torque(rotor);
+        for (int r = 0; r < 3; r++)
+        {
+            force[r] += wheel_jacobian[i][r] * torque;
+            for (int c = 0; c < 3; c++)
+            {
+                mass[r][c] += rotor->inertia * wheel_jacobian[i][r] * wheel_jacobian[i][c];
+            }
+        }
+    }
+
+    float accel[3];
+    solve_3x3(mass, force, accel);
+    for (int r = 0; r < 3; r++)
+    {
+        v[r] += accel[r] * dt;
+    }
+    sim_plant.chassis_yaw += v[2] * dt;
+
+    // wheels follow the chassis
+    for (int i = 0; i < 4; i++)
+    {
+        SimRotor *rotor = &sim_plant.rotor[CHASSIS_FR + i];
+        rotor->velocity = wheel_jacobian[i][0] * v[0] + wheel_jacobian[i][1] * v[1] + wheel_jacobian[i][2] * v[2];
+        rotor->angle += rotor->velocity * dt;
+    }
+}
+
+static void gimbal_update(float dt)
+{
+    // yaw: motor torque acts between chassis and gimbal, friction on the relative speed
+    SimRotor *yaw = &sim_plant.rotor[GIMBAL_YAW];
+    yaw->velocity = sim_plant.gimbal_yaw_rate - sim_plant.chassis_v[2];
+    sim_plant.gimbal_yaw_rate += rotor_torque(yaw) / yaw->inertia * dt;
+    sim_plant.gimbal_yaw += sim_plant.gimbal_yaw_rate * dt;
+    yaw->velocity = sim_plant.gimbal_yaw_rate - sim_plant.chassis_v[2];
+    yaw->angle = sim_plant.gimbal_yaw - sim_plant.chassis_yaw;
+
+    // pitch: gravity and hard stops
+    SimRotor *pitch = &sim_plant.rotor[GIMBAL_PITCH];
+    free_rotor_update(pitch, -sim_plant.pitch_gravity * cosf(pitch->angle), dt);
+    if (pitch->angle < sim_plant.pitch_limit[0] || pitch->angle > sim_plant.pitch_limit[1])
+    {
+        pitch->angle = val_limit_float(pitch->angle, sim_plant.pitch_limit[0], sim_plant.pitch_limit[1]);
+        pitch->velocity = 0.0f;
+    }
+}
+
+// the escs' side of motor_topology.h: the frame and slot each motor listens to
+typedef struct
+{
+    uint8_t bus; // host_can bus number
+    uint32_t std_id;
+} SimCommandFrame;
+
+#define SIM_FRAME_ENTRY(frame, bus_, id) [frame] = {.bus = (bus_) == MOTOR_CAN1 ? 1 : 3, .std_id = (id)},
+static const SimCommandFrame sim_command_frame[MOTOR_TX_NUM] = {MOTOR_TX_TOPOLOGY(SIM_FRAME_ENTRY)};
+
+#define SIM_ROUTE_ENTRY(index, type, bus, rx_id, frame, slot, reduction, zero) [index] = {(frame), (slot)},
+static const uint8_t sim_command_route[TOTAL_MOTOR_NUM][2] = {MOTOR_TOPOLOGY(SIM_ROUTE_ENTRY)}; // frame, slot
+
+static void command_receive(const HostCanFrame *frame)
+{
+    for (int i = 0; i < TOTAL_MOTOR_NUM; i++)
+    {
+        const SimCommandFrame *command = &sim_command_frame[sim_command_route[i][0]];
+        if (frame->bus != command->bus || frame->std_id != command->std_id)
+        {
+            continue;
+        }
+
+        int16_t value = read_int16(&frame->data[2 * sim_command_route[i][1]]);
+        switch (motors[i].type)
+        {
+        case M3508:
+            sim_plant.rotor[i].command = M3508_CURRENT_INT_TO_FLOAT(value);
+            break;
+        case M2006:
+            sim_plant.rotor[i].command = M2006_CURRENT_INT_TO_FLOAT(value);
+            break;
+        case GM6020:
+        default:
+            sim_plant.rotor[i].command = GM6020_VOLTAGE_INT_TO_FLOAT(value);
+            break;
+        }
+    }
+}
+
+/*
+ **************************************************************************
+ * exposed interfaces
+ **************************************************************************
+ */
+void sim_plant_init(void)
+{
+    memset(&sim_plant, 0, sizeof(sim_plant));
+
+    for (int i = CHASSIS_FR; i <= CHASSIS_BR; i++)
+    {
+        sim_plant.rotor[i] = M3508_WHEEL;
+    }
+    sim_plant.rotor[GIMBAL_YAW] = GM6020_YAW;
+    sim_plant.rotor[GIMBAL_PITCH] = GM6020_PITCH;
+    sim_plant.rotor[FRICTION_L] = M3508_FRICTION;
+    sim_plant.rotor[FRICTION_R] = M3508_FRICTION;
+    sim_plant.rotor[TRIGGER] = M2006_TRIGGER;
+
+    sim_plant.chassis_mass = 18.0f;
+    sim_plant.chassis_inertia = 0.6f;
+    sim_plant.chassis_half = 0.2f;
+    sim_plant.pitch_gravity = 0.3f;
+    sim_plant.pitch_limit[0] = (666.0f - 1430.0f) / SIM_ENCODER_COUNTS * 2.0f * PI;
+    sim_plant.pitch_limit[1] = (2190.0f - 1430.0f) / SIM_ENCODER_COUNTS * 2.0f * PI;
+    sim_plant.supply_voltage = 24.0f;
+
+    // rotor speed = gear / radius * sign * dir . (v + wz x p)
+    for (int i = 0; i < 4; i++)
+    {
+        float scale = M3508_GEAR_RATIO / WHEEL_RADIUS * wheel_sign[i] / sqrtf(2.0f);
+        float p_x = wheel_pos[i][0] * sim_plant.chassis_half;
+        float p_y = wheel_pos[i][1] * sim_plant.chassis_half;
+        wheel_jacobian[i][0] = scale * wheel_dir[i][0];
+        wheel_jacobian[i][1] = scale * wheel_dir[i][1];
+        wheel_jacobian[i][2] = scale * (p_x * wheel_dir[i][1] - p_y * wheel_dir[i][0]);
+    }
+
+    host_can_set_tx_hook(command_receive);
+}
+
+void sim_plant_step(float dt)
+{
+    SimRotor *rotor = sim_plant.rotor;
+
+    // electrical
+    for (int i = 0; i < TOTAL_MOTOR_NUM; i++)
+    {
+        if (i == GIMBAL_YAW || i == GIMBAL_PITCH)
+        {
+            voltage_driven_update(&rotor[i], dt);
+        }
+        else
+        {
+            current_driven_update(&rotor[i], dt);
+        }
+    }
+
+    // mechanical
+    chassis_update(dt);
+    gimbal_update(dt);
+    free_rotor_update(&rotor[FRICTION_L], 0.0f, dt);
+    free_rotor_update(&rotor[FRICTION_R], 0.0f, dt);
+    free_rotor_update(&rotor[TRIGGER], 0.0f, dt);
+
+    sim_plant.time += dt;
+}
+
+void sim_plant_send_feedback(void)
+{
+    uint8_t buff[8];
+
+    for (int i = 0; i < TOTAL_MOTOR_NUM; i++)
+    {
+        SimRotor *rotor = &sim_plant.rotor[i];
+
+        // 13 bit single turn angle and integer rpm, as the esc reports them
+        float turns = rotor->angle / (2.0f * PI);
+        float counts = (turns - floorf(turns)) * SIM_ENCODER_COUNTS + rotor->encoder_offset;
+        uint16_t raw_angle = (uint16_t)counts % (uint16_t)SIM_ENCODER_COUNTS;
+        int16_t raw_velocity = (int16_t)lrintf(rotor->velocity * 60.0f / (2.0f * PI));
+        int16_t raw_current;
+        switch (motors[i].type)
+        {
+        case M3508:
+            raw_current = M3508_CURRENT_FLOAT_TO_INT(rotor->current);
+            break;
+        case M2006:
+            raw_current = M2006_CURRENT_FLOAT_TO_INT(rotor->current);
+            break;
+        case GM6020:
+        default:
+            raw_current = GM6020_CURRENT_FLOAT_TO_INT(rotor->current);
+            break;
+        }
+
+        write_int16(&buff[0], (int16_t)raw_angle);
+        write_int16(&buff[2], raw_velocity);
+        write_int16(&buff[4], raw_current);
+        buff[6] = SIM_TEMPERATURE;
+        buff[7] = 0;
+
+        motor_data_interpret(buff, &motors[i]);
+    }
+}
+
+float sim_plant_yaw_angle(void)
+{
+    float angle = sim_plant.rotor[GIMBAL_YAW].angle;
+    return angle - 2.0f * PI * floorf((angle + PI) / (2.0f * PI));
+}
+
+float sim_plant_pitch_angle(void)
+{
+    return sim_plant.rotor[GIMBAL_PITCH].angle;
+}
+
+float sim_plant_wheel_power(void)
+{
+    float power = 0.0f;
+    for (int i = CHASSIS_FR; i <= CHASSIS_BR; i++)
+    {
+        SimRotor *rotor = &sim_plant.rotor[i];
+        power += rotor->current * (rotor->current * rotor->resistance + rotor->kt * rotor->velocity);
+    }
+    return power;
+}
+
+/*
+ **************************************************************************
+ * imu stand-in
+ **************************************************************************
+ */
+// the main control board sits on the chassis, its imu reads the chassis attitude without noise or bias
+void imu_read_data(ImuData *data)
+{
+    memset(data, 0, sizeof(*data));
+    data->q.q_w = cosf(0.5f * sim_plant.chassis_yaw);
+    data->q.q_z = sinf(0.5f * sim_plant.chassis_yaw);
+    data->angle_yaw = sim_plant.chassis_yaw - 2.0f * PI * floorf((sim_plant.chassis_yaw + PI) / (2.0f * PI));
+    data->velocity_yaw = sim_plant.chassis_v[2];
+}
+
+uint8_t imu_is_ready(void)
+{
+    return 1;
+}
@@ -0,0 +1,272 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "mahony.h"
+#include "eskf.h"
+
+/*
+ * attitude filters on a synthetic bmi088 stream with a known gyro bias
+ *
+ * usage: filter_bench [seconds] [still_seconds]
+ *   seconds        match length, default 420 (7 min)
+ *   still_seconds  the robot stands still before the match, default 10
+ *
+ * the stream: still, then yaw sweeps of the gimbal with small roll / pitch motion and
+ * chassis accelerations, gyro = rate + bias + white noise, accel = gravity + motion + noise
+ * reports yaw drift, worst roll / pitch error, bias error and convergence time, host ns per update
+ */
+
+#define BENCH_RATE (1000) // Hz
+
+#define GYRO_SIGMA (0.003)  // rad/s, per sample white noise
+#define ACCEL_SIGMA (0.003) // g, per sample white noise
+#define BIAS_TOLERANCE (5.0e-4) // rad/s, bias counted as converged below this error
+
+static const double true_bias[3] = {0.004, -0.003, 0.006}; // rad/s, left after gyro_cal
+
+typedef struct
+{
+    const char *name;
+    void (*update)(void *filter, float32_t gyro[3], float32_t accel[3]);
+    void (*euler)(void *filter, float32_t euler[3]);
+    const float32_t *bias; // NULL: no bias estimate
+    void *filter;
+
+    double yaw_error;
+    double tilt_error_max;
+    double converge_time; // s, -1: never
+    double elapsed;       // s, host time in update
+} FilterRun;
+
+static MahonyFilter mahony;
+static EskfFilter eskf;
+
+static void mahony_run(void *filter, float32_t gyro[3], float32_t accel[3])
+{
+    mahony_update((MahonyFilter *)filter, gyro, accel);
+}
+
+static void mahony_euler(void *filter, float32_t euler[3])
+{
+    mahony_get_euler((MahonyFilter *)filter, euler);
+}
+
+static void eskf_run(void *filter, float32_t gyro[3], float32_t accel[3])
+{
+    eskf_update((EskfFilter *)filter, gyro, accel);
+}
+
+static void eskf_euler(void *filter, float32_t euler[3])
+{
+    eskf_get_euler((EskfFilter *)filter, euler);
+}
+
+/*
+ **************************************************************************
+ * synthetic truth, double precision
+ **************************************************************************
+ */
+static double gauss(void)
+{
+    // box-muller
+    double u1 = (rand() + 1.0) / (RAND_MAX + 2.0);
+    double u2 = (rand() + 1.0) / (RAND_MAX + 2.0);
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+static void truth_rate(double t, double still, double w[3])
+{
+    if (t < still)
+    {
+        w[0] = w[1] = w[2] = 0.0;
+        return;
+    }
+    t -= still;
+    w[0] = 0.15 * sin(2.0 * M_PI * 0.7 * t);
+    w[1] = 0.25 * sin(2.0 * M_PI * 0.4 * t + 1.0);
+    w[2] = 2.0 * sin(2.0 * M_PI * 0.25 * t);
+}
+
+static void truth_accel(double t, double still, double a_world[3])
+{
+    a_world[0] = a_world[1] = a_world[2] = 0.0;
+    if (t >= still)
+    {
+        // chassis accelerating back and forth, in g
+        a_world[0] = 0.08 * sin(2.0 * M_PI * 0.3 * t);
+        a_world[1] = 0.05 * cos(2.0 * M_PI * 0.2 * t);
+    }
+}
+
+static void truth_step(double q[4], const double w[3], double dt)
+{
+    double h[3] = {0.5 * w[0] * dt, 0.5 * w[1] * dt, 0.5 * w[2] * dt};
+    double theta = sqrt(h[0] * h[0] + h[1] * h[1] + h[2] * h[2]);
+    double s = theta > 1e-12 ? sin(theta) / theta : 1.0;
+    double d[4] = {cos(theta), h[0] * s, h[1] * s, h[2] * s};
+    double r[4] = {
+        q[0] * d[0] - q[1] * d[1] - q[2] * d[2] - q[3] * d[3],
+        q[0] * d[1] + q[1] * d[0] + q[2] * d[3] - q[3] * d[2],
+        q[0] * d[2] - q[1] * d[3] + q[2] * d[0] + q[3] * d[1],
+        q[0] * d[3] + q[1] * d[2] - q[2] * d[1] + q[3] * d[0],
+    };
+    double n = sqrt(r[0] * r[0] + r[1] * r[1] + r[2] * r[2] + r[3] * r[3]);
+    for (int i = 0; i < 4; i++)
+    {
+        q[i] = r[i] / n;
+    }
+}
+
+static void truth_to_body(const double q[4], const double v[3], double out[3])
+{
+    // R^T v
+    double w = q[0], x = q[1], y = q[2], z = q[3];
+    double R[3][3] = {
+        {1 - 2 * (y * y + z * z), 2 * (x * y - w * z), 2 * (x * z + w * y)},
+        {2 * (x * y + w * z), 1 - 2 * (x * x + z * z), 2 * (y * z - w * x)},
+        {2 * (x * z - w * y), 2 * (y * z + w * x), 1 - 2 * (x * x + y * y)},
+    };
+    for (int i = 0; i < 3; i++)
+    {
+        out[i] = R[0][i] * v[0] + R[1][i] * v[1] + R[2][i] * v[2];
+    }
+}
+
+static void truth_euler(const double q[4], double euler[3])
+{
+    double w = q[0], x = q[1], y = q[2], z = q[3];
+    euler[2] = atan2(2 * (w * x + y * z), 1 - 2 * (x * x + y * y));
+    double sp = 2 * (w * y - z * x);
+    euler[1] = asin(sp > 1 ? 1 : (sp < -1 ? -1 : sp));
+    euler[0] = atan2(2 * (w * z + x * y), 1 - 2 * (y * y + z * z));
+}
+
+static double wrap(double angle)
+{
+    while (angle > M_PI)
+        angle -= 2 * M_PI;
+    while (angle < -M_PI)
+        angle += 2 * M_PI;
+    return angle;
+}
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1.0e-9;
+}
+
+/*
+ **************************************************************************
+ * main loop
+ **************************************************************************
+ */
+int main(int argc, char **argv)
+{
+    double duration = (argc > 1) ? atof(argv[1]) : 420.0;
+    double still = (argc > 2) ? atof(argv[2]) : 10.0;
+    if (duration <= 0.0 || still < 0.0)
+    {
+        fprintf(stderr, "usage: filter_bench [seconds] [still_seconds]\n");
+        return 1;
+    }
+
+    // same tuning as Device/Src/imu.c
+    mahony_init(&mahony, 0.6f, 0.0f, 0.0f, BENCH_RATE);
+    eskf_init(&eskf, ESKF_GYRO_NOISE, ESKF_BIAS_WALK, ESKF_ACCEL_NOISE, BENCH_RATE);
+
+    FilterRun runs[] = {
+        {"mahony", mahony_run, mahony_euler, NULL, &mahony, 0, 0, -1, 0},
+        {"eskf", eskf_run, eskf_euler, eskf.bias, &eskf, 0, 0, -1, 0},
+    };
+    int run_num = sizeof(runs) / sizeof(runs[0]);
+
+    srand(7);
+    double q[4] = {1.0, 0.0, 0.0, 0.0};
+    double dt = 1.0 / BENCH_RATE;
+    long steps = (long)((still + duration) * BENCH_RATE);
+    for (long k = 0; k < steps; k++)
+    {
+        double t = k * dt;
+        double w[3], a_world[3], a_body[3];
+        truth_rate(t, still, w);
+        truth_step(q, w, dt);
+        truth_accel(t, still, a_world);
+        a_world[2] += 1.0; // the accelerometer measures -g, +z up
+        truth_to_body(q, a_world, a_body);
+
+        float32_t gyro[3], accel[3];
+        for (int i = 0; i < 3; i++)
+        {
+            gyro[i] = (float32_t)(w[i] + true_bias[i] + GYRO_SIGMA * gauss());
+            accel[i] = (float32_t)(a_body[i] + ACCEL_SIGMA * gauss());
+        }
+
+        double euler_true[3];
+        truth_euler(q, euler_true);
+        for (int r = 0; r < run_num; r++)
+        {
+            FilterRun *run = &runs[r];
+            double start = now_seconds();
+            run->update(run->filter, gyro, accel);
+            run->elapsed += now_seconds() - start;
+
+            float32_t euler[3];
+            run->euler(run->filter, euler);
+            run->yaw_error = wrap(euler[0] - euler_true[0]);
+            double tilt = fmax(fabs(wrap(euler[1] - euler_true[1])), fabs(wrap(euler[2] - euler_true[2])));
+            if (t > 1.0 && tilt > run->tilt_error_max)
+            {
+                run->tilt_error_max = tilt;
+            }
+
+            if (run->bias != NULL)
+            {
+                double err = 0.0;
+                for (int i = 0; i < 3; i++)
+                {
+                    err = fmax(err, fabs(run->bias[i] - true_bias[i]));
+                }
+                if (err > BIAS_TOLERANCE)
+                {
+                    run->converge_time = -1;
+                }
+                else if (run->converge_time < 0)
+                {
+                    run->converge_time = t;
+                }
+            }
+        }
+    }
+
+    printf("%.0f s still + %.0f s match, bias (%.4f, %.4f, %.4f) rad/s\n",
+           still, duration, true_bias[0], true_bias[1], true_bias[2]);
+    printf("%-8s %12s %14s %14s %16s %10s\n", "filter", "yaw drift", "max roll/pitch", "bias error", "bias converged", "ns/update");
+    for (int r = 0; r < run_num; r++)
+    {
+        FilterRun *run = &runs[r];
+        printf("%-8s %9.2f deg %10.3f deg", run->name, run->yaw_error * 180.0 / M_PI, run->tilt_error_max * 180.0 / M_PI);
+        if (run->bias != NULL)
+        {
+            double err = 0.0;
+            for (int i = 0; i < 3; i++)
+            {
+                err = fmax(err, fabs(run->bias[i] - true_bias[i]));
+            }
+            printf(" %10.5f r/s", err);
+            if (run->converge_time >= 0)
+                printf(" %14.2f s", run->converge_time);
+            else
+                printf(" %16s", "never");
+        }
+        else
+        {
+            printf(" %14s %16s", "-", "-");
+        }
+        printf(" %10.1f\n", run->elapsed * 1.0e9 / steps);
+    }
+    return 0;
+}
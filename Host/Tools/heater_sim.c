@@ -0,0 +1,173 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "heater.h"
+
+/*
+ * heater controller against a thermal model of the imu board
+ *
+ * usage: heater_sim [seconds] [-t]   -t dumps time, die temperature, reading, duty, ready as csv instead
+ *
+ * board: first order, full power lifts it HEATER_SIM_RISE above ambient with time constant HEATER_SIM_TAU,
+ * the die lags the board by HEATER_SIM_DIE_TAU, the reading is the bmi088 register: 0.125 degC steps every 1.28 s
+ * at half time a fan blows on the board for HEATER_SIM_GUST s, the losses rise by half
+ *
+ * pass: every ambient within its row of heater_limits, time to ready, die overshoot and rms while ready,
+ * exits 1 otherwise, the limits hold for the default 900 s
+ */
+
+#define HEATER_SIM_DT (0.01)        // s, model step
+#define HEATER_SIM_TAU (90.0)       // s, board
+#define HEATER_SIM_DIE_TAU (8.0)    // s, die behind the board
+#define HEATER_SIM_RISE (45.0)      // degC above ambient at full power
+#define HEATER_SIM_SENSOR_T (1.28)  // s, bmi088 temperature update
+#define HEATER_SIM_SENSOR_Q (0.125) // degC, bmi088 temperature resolution
+#define HEATER_SIM_GUST (60.0)      // s
+#define HEATER_SIM_GUST_LOSS (1.5)  // loss factor during the gust
+
+typedef struct
+{
+    double ambient;       // degC
+    double ready_max;     // s
+    double overshoot_max; // degC
+    double rms_max;       // degC
+} HeaterLimit;
+
+// about 20 % over the current results, at 10 degC the gust needs more than full power and ready is lost
+static const HeaterLimit heater_limits[] = {
+    {10.0, 200.0, 1.2, 1.0},
+    {25.0, 80.0, 0.9, 0.25},
+    {35.0, 45.0, 0.75, 0.18},
+};
+
+typedef struct
+{
+    double ready_time; // s, -1 when never ready
+    double overshoot;  // degC above the target, die
+    double rms;        // degC, die error while ready
+    double max_error;  // degC, die error while ready
+    double duty;       // mean duty while ready
+    int lost;          // ready cleared after it was set
+} HeaterRun;
+
+static HeaterRun run(double ambient, double seconds, int trace)
+{
+    Heater heater;
+    heater_init(&heater, HEATER_TARGET);
+
+    HeaterRun r = {.ready_time = -1.0};
+    double board = ambient, die = ambient, reading = ambient;
+    double duty = 0.0, next_sample = 0.0, next_control = 0.0;
+    double sum_sq = 0.0, sum_duty = 0.0;
+    long ready_steps = 0;
+    uint8_t was_ready = 0;
+    double gust_start = seconds / 2.0;
+
+    for (long k = 0; k * HEATER_SIM_DT < seconds; k++)
+    {
+        double t = k * HEATER_SIM_DT;
+
+        // sensor register
+        if (t >= next_sample)
+        {
+            reading = HEATER_SIM_SENSOR_Q * floor(die / HEATER_SIM_SENSOR_Q + 0.5);
+            next_sample += HEATER_SIM_SENSOR_T;
+        }
+
+        // controller
+        if (t >= next_control)
+        {
+            duty = heater_update(&heater, (float)reading);
+            next_control += HEATER_PERIOD;
+            if (heater.ready && !was_ready && r.ready_time < 0.0)
+            {
+                r.ready_time = t;
+            }
+            if (!heater.ready && was_ready)
+            {
+                r.lost++;
+            }
+            was_ready = heater.ready;
+            if (trace)
+            {
+                printf("%.2f,%.4f,%.3f,%.4f,%d\n", t, die, reading, duty, heater.ready);
+            }
+        }
+
+        // plant
+        double loss = (t >= gust_start && t < gust_start + HEATER_SIM_GUST) ? HEATER_SIM_GUST_LOSS : 1.0;
+        board += HEATER_SIM_DT / HEATER_SIM_TAU * (HEATER_SIM_RISE * duty - loss * (board - ambient));
+        die += HEATER_SIM_DT / HEATER_SIM_DIE_TAU * (board - die);
+
+        // statistics
+        double error = die - HEATER_TARGET;
+        if (error > r.overshoot)
+        {
+            r.overshoot = error;
+        }
+        if (r.ready_time >= 0.0)
+        {
+            sum_sq += error * error;
+            sum_duty += duty;
+            ready_steps++;
+            if (fabs(error) > r.max_error)
+            {
+                r.max_error = fabs(error);
+            }
+        }
+    }
+
+    if (ready_steps > 0)
+    {
+        r.rms = sqrt(sum_sq / ready_steps);
+        r.duty = sum_duty / ready_steps;
+    }
+    return r;
+}
+
+int main(int argc, char **argv)
+{
+    double seconds = 900.0;
+    int trace = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (argv[i][0] == '-' && argv[i][1] == 't')
+        {
+            trace = 1;
+        }
+        else
+        {
+            seconds = atof(argv[i]);
+        }
+    }
+
+    if (trace)
+    {
+        printf("t,die,reading,duty,ready\n");
+        run(25.0, seconds, 1);
+        return 0;
+    }
+
+    printf("target %.1f degC, board tau %.0f s, full power +%.0f degC, gust x%.1f losses for %.0f s at %.0f s\n",
+           HEATER_TARGET, HEATER_SIM_TAU, HEATER_SIM_RISE, HEATER_SIM_GUST_LOSS, HEATER_SIM_GUST, seconds / 2.0);
+    printf("ambient  ready(s)  overshoot  rms(ready)  max(ready)  duty  lost\n");
+    int fail = 0;
+    for (unsigned i = 0; i < sizeof(heater_limits) / sizeof(heater_limits[0]); i++)
+    {
+        const HeaterLimit *limit = &heater_limits[i];
+        HeaterRun r = run(limit->ambient, seconds, 0);
+        int ok = r.ready_time >= 0.0 && r.ready_time <= limit->ready_max && r.overshoot <= limit->overshoot_max &&
+                 r.rms <= limit->rms_max;
+        fail |= !ok;
+        printf("%5.1f   %8.1f   %6.3f     %6.3f      %6.3f    %5.3f  %d  %s\n", limit->ambient, r.ready_time, r.overshoot,
+               r.rms, r.max_error, r.duty, r.lost, ok ? "ok" : "FAIL");
+    }
+    printf("limits ready / overshoot / rms:");
+    for (unsigned i = 0; i < sizeof(heater_limits) / sizeof(heater_limits[0]); i++)
+    {
+        printf("  %.0f degC %.0f s %.2f %.2f", heater_limits[i].ambient, heater_limits[i].ready_max,
+               heater_limits[i].overshoot_max, heater_limits[i].rms_max);
+    }
+    printf("\n%s\n", fail ? "FAIL" : "pass");
+    return fail;
+}
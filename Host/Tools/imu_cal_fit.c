@@ -0,0 +1,506 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "imu_cal.h"
+
+/*
+ * fit the ImuCal parameters (Algorithm/Inc/imu_cal.h) from recorded static poses
+ *
+ * usage: imu_cal_fit <poses.txt>
+ *        imu_cal_fit -s    fit a synthetic board with a known calibration and report the errors
+ *
+ * one pose per line: ax ay az gx gy gz temp, imu_raw_data averaged over a second or more of standing still,
+ * separated by spaces or commas, '#' starts a comment
+ * accel: at least 9 poses spread over the sphere (6 faces and the 8 corners is a good set),
+ *        |M (a - offset)| = 1 g fitted as an ellipsoid, M symmetric, a rotation of the sensor keeps |a| and is not seen
+ * gyro: bias against temperature, a quadratic per axis sampled into the table, record the poses while the board warms up
+ * prints the initializer for imu_cal in Device/Src/imu.c
+ */
+
+#define FIT_MAX_POSES (256)
+#define FIT_TEMP_SPAN_MIN (1.0) // degC, below this the table has a single entry
+
+typedef struct
+{
+    double accel[3];
+    double gyro[3];
+    double temp;
+} Pose;
+
+/*
+ **************************************************************************
+ * linear algebra, double precision
+ **************************************************************************
+ */
+// solve A x = b in place, n <= 9, returns -1 when singular
+static int solve(double *A, double *b, int n)
+{
+    for (int c = 0; c < n; c++)
+    {
+        int pivot = c;
+        for (int r = c + 1; r < n; r++)
+        {
+            if (fabs(A[r * n + c]) > fabs(A[pivot * n + c]))
+            {
+                pivot = r;
+            }
+        }
+        if (fabs(A[pivot * n + c]) < 1e-12)
+        {
+            return -1;
+        }
+        for (int k = 0; k < n; k++)
+        {
+            double t = A[c * n + k];
+            A[c * n + k] = A[pivot * n + k];
+            A[pivot * n + k] = t;
+        }
+        double t = b[c];
+        b[c] = b[pivot];
+        b[pivot] = t;
+
+        for (int r = c + 1; r < n; r++)
+        {
+            double f = A[r * n + c] / A[c * n + c];
+            for (int k = c; k < n; k++)
+            {
+                A[r * n + k] -= f * A[c * n + k];
+            }
+            b[r] -= f * b[c];
+        }
+    }
+    for (int r = n - 1; r >= 0; r--)
+    {
+        for (int k = r + 1; k < n; k++)
+        {
+            b[r] -= A[r * n + k] * b[k];
+        }
+        b[r] /= A[r * n + r];
+    }
+    return 0;
+}
+
+// least squares through the normal equations, rows of n columns
+static int least_squares(const double *rows, const double *rhs, int m, int n, double *x)
+{
+    double AtA[9 * 9] = {0}, Atb[9] = {0};
+    for (int i = 0; i < m; i++)
+    {
+        for (int r = 0; r < n; r++)
+        {
+            for (int c = 0; c < n; c++)
+            {
+                AtA[r * n + c] += rows[i * n + r] * rows[i * n + c];
+            }
+            Atb[r] += rows[i * n + r] * rhs[i];
+        }
+    }
+    if (solve(AtA, Atb, n) != 0)
+    {
+        return -1;
+    }
+    memcpy(x, Atb, n * sizeof(double));
+    return 0;
+}
+
+// eigen decomposition of a symmetric 3x3 by jacobi rotations, S = V diag(d) V^T
+static void eigen_symmetric(const double S[3][3], double d[3], double V[3][3])
+{
+    double A[3][3];
+    memcpy(A, S, sizeof(A));
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            V[i][j] = (i == j);
+        }
+    }
+
+    for (int sweep = 0; sweep < 50; sweep++)
+    {
+        double off = A[0][1] * A[0][1] + A[0][2] * A[0][2] + A[1][2] * A[1][2];
+        if (off < 1e-30)
+        {
+            break;
+        }
+        for (int p = 0; p < 2; p++)
+        {
+            for (int q = p + 1; q < 3; q++)
+            {
+                if (fabs(A[p][q]) < 1e-300)
+                {
+                    continue;
+                }
+                double theta = (A[q][q] - A[p][p]) / (2.0 * A[p][q]);
+                double t = (theta >= 0 ? 1.0 : -1.0) / (fabs(theta) + sqrt(theta * theta + 1.0));
+                double c = 1.0 / sqrt(t * t + 1.0), s = t * c;
+                for (int k = 0; k < 3; k++)
+                {
+                    double akp = A[k][p], akq = A[k][q];
+                    A[k][p] = c * akp - s * akq;
+                    A[k][q] = s * akp + c * akq;
+                }
+                for (int k = 0; k < 3; k++)
+                {
+                    double apk = A[p][k], aqk = A[q][k];
+                    A[p][k] = c * apk - s * aqk;
+                    A[q][k] = s * apk + c * aqk;
+                }
+                for (int k = 0; k < 3; k++)
+                {
+                    double vkp = V[k][p], vkq = V[k][q];
+                    V[k][p] = c * vkp - s * vkq;
+                    V[k][q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        d[i] = A[i][i];
+    }
+}
+
+/*
+ **************************************************************************
+ * fits
+ **************************************************************************
+ */
+// x^T Q x + 2 v^T x = 1, then M = sqrt(Q / (1 + o^T Q o)), o = -Q^-1 v
+static int fit_accel(const Pose *poses, int num, double M[3][3], double offset[3])
+{
+    static double rows[FIT_MAX_POSES * 9], rhs[FIT_MAX_POSES];
+    for (int i = 0; i < num; i++)
+    {
+        const double *a = poses[i].accel;
+        double *row = &rows[i * 9];
+        row[0] = a[0] * a[0];
+        row[1] = a[1] * a[1];
+        row[2] = a[2] * a[2];
+        row[3] = 2 * a[0] * a[1];
+        row[4] = 2 * a[0] * a[2];
+        row[5] = 2 * a[1] * a[2];
+        row[6] = 2 * a[0];
+        row[7] = 2 * a[1];
+        row[8] = 2 * a[2];
+        rhs[i] = 1.0;
+    }
+    double p[9];
+    if (least_squares(rows, rhs, num, 9, p) != 0)
+    {
+        return -1;
+    }
+
+    double Q[3][3] = {{p[0], p[3], p[4]}, {p[3], p[1], p[5]}, {p[4], p[5], p[2]}};
+    double QA[9], v[3] = {-p[6], -p[7], -p[8]};
+    memcpy(QA, Q, sizeof(QA));
+    if (solve(QA, v, 3) != 0)
+    {
+        return -1;
+    }
+    memcpy(offset, v, sizeof(v));
+
+    double k = 1.0;
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            k += offset[i] * Q[i][j] * offset[j];
+        }
+    }
+
+    double d[3], V[3][3];
+    eigen_symmetric(Q, d, V);
+    for (int i = 0; i < 3; i++)
+    {
+        if (d[i] / k <= 0.0)
+        {
+            return -1; // not an ellipsoid, the poses do not cover enough directions
+        }
+        d[i] = sqrt(d[i] / k);
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            M[i][j] = V[i][0] * d[0] * V[j][0] + V[i][1] * d[1] * V[j][1] + V[i][2] * d[2] * V[j][2];
+        }
+    }
+    return 0;
+}
+
+// bias(T) = c0 + c1 u + c2 u^2 per axis, u = T - t_mean, degree limited by the temperature spread
+static int fit_gyro(const Pose *poses, int num, double t_mean, int degree, double coef[3][3])
+{
+    static double rows[FIT_MAX_POSES * 3], rhs[FIT_MAX_POSES];
+    int n = degree + 1;
+    for (int axis = 0; axis < 3; axis++)
+    {
+        for (int i = 0; i < num; i++)
+        {
+            double u = poses[i].temp - t_mean;
+            rows[i * n + 0] = 1.0;
+            if (n > 1)
+                rows[i * n + 1] = u;
+            if (n > 2)
+                rows[i * n + 2] = u * u;
+            rhs[i] = poses[i].gyro[axis];
+        }
+        memset(coef[axis], 0, 3 * sizeof(double));
+        if (least_squares(rows, rhs, num, n, coef[axis]) != 0)
+        {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/*
+ **************************************************************************
+ * input and synthetic board
+ **************************************************************************
+ */
+static int read_poses(const char *path, Pose *poses)
+{
+    FILE *file = fopen(path, "r");
+    if (file == NULL)
+    {
+        perror(path);
+        return -1;
+    }
+
+    char line[256];
+    int num = 0;
+    while (fgets(line, sizeof(line), file) != NULL && num < FIT_MAX_POSES)
+    {
+        char *comment = strchr(line, '#');
+        if (comment != NULL)
+        {
+            *comment = '\0';
+        }
+        for (char *c = line; *c; c++)
+        {
+            if (*c == ',')
+                *c = ' ';
+        }
+        Pose *p = &poses[num];
+        int n = sscanf(line, "%lf %lf %lf %lf %lf %lf %lf", &p->accel[0], &p->accel[1], &p->accel[2],
+                       &p->gyro[0], &p->gyro[1], &p->gyro[2], &p->temp);
+        if (n == 7)
+        {
+            num++;
+        }
+        else if (n > 0)
+        {
+            fprintf(stderr, "%s: skipped a line with %d values\n", path, n);
+        }
+    }
+    fclose(file);
+    return num;
+}
+
+static double gauss(void)
+{
+    // box-muller
+    double u1 = (rand() + 1.0) / (RAND_MAX + 2.0);
+    double u2 = (rand() + 1.0) / (RAND_MAX + 2.0);
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+// known board: a_raw = M^-1 g + offset, gyro = bias(T), poses on the faces, edges and corners while warming up
+// symmetric, as the ellipsoid fit returns
+static const double true_M[3][3] = {{1.021, 0.006, -0.004}, {0.006, 0.987, 0.009}, {-0.004, 0.009, 1.012}};
+static const double true_offset[3] = {0.021, -0.014, 0.032};
+
+static double true_bias(int axis, double temp)
+{
+    static const double b0[3] = {0.004, -0.002, 0.003}, b1[3] = {1.5e-4, -0.8e-4, 2.0e-4}, b2[3] = {2e-6, 1e-6, -3e-6};
+    double u = temp - 25.0;
+    return b0[axis] + b1[axis] * u + b2[axis] * u * u;
+}
+
+static int synthetic_poses(Pose *poses)
+{
+    // M^-1 by cofactors
+    const double(*m)[3] = true_M;
+    double det = m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) - m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+                 m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+    double inv[3][3];
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            int r0 = (j + 1) % 3, r1 = (j + 2) % 3, c0 = (i + 1) % 3, c1 = (i + 2) % 3;
+            inv[i][j] = (m[r0][c0] * m[r1][c1] - m[r0][c1] * m[r1][c0]) / det;
+        }
+    }
+
+    int num = 0;
+    for (int x = -1; x <= 1; x++)
+    {
+        for (int y = -1; y <= 1; y++)
+        {
+            for (int z = -1; z <= 1; z++)
+            {
+                if (x == 0 && y == 0 && z == 0)
+                {
+                    continue;
+                }
+                double n = sqrt((double)(x * x + y * y + z * z));
+                double g[3] = {x / n, y / n, z / n};
+                Pose *p = &poses[num];
+                p->temp = 25.0 + 30.0 * num / 25.0 + 0.1 * gauss(); // warming up over the session
+                for (int i = 0; i < 3; i++)
+                {
+                    p->accel[i] = inv[i][0] * g[0] + inv[i][1] * g[1] + inv[i][2] * g[2] + true_offset[i] +
+                                  3e-4 * gauss(); // 1 s average of the bmi088 noise
+                    p->gyro[i] = true_bias(i, p->temp) + 1e-4 * gauss();
+                }
+                num++;
+            }
+        }
+    }
+    return num;
+}
+
+/*
+ **************************************************************************
+ * main
+ **************************************************************************
+ */
+int main(int argc, char **argv)
+{
+    static Pose poses[FIT_MAX_POSES];
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: imu_cal_fit <poses.txt> | -s\n");
+        return 1;
+    }
+    int synthetic = strcmp(argv[1], "-s") == 0;
+    int num = synthetic ? synthetic_poses(poses) : read_poses(argv[1], poses);
+    if (num < 9)
+    {
+        fprintf(stderr, "need at least 9 poses, got %d\n", num < 0 ? 0 : num);
+        return 1;
+    }
+
+    // accel
+    double M[3][3], offset[3];
+    if (fit_accel(poses, num, M, offset) != 0)
+    {
+        fprintf(stderr, "accel fit failed, the poses do not cover enough directions\n");
+        return 1;
+    }
+
+    // gyro
+    double t_min = poses[0].temp, t_max = poses[0].temp, t_mean = 0.0;
+    for (int i = 0; i < num; i++)
+    {
+        t_min = fmin(t_min, poses[i].temp);
+        t_max = fmax(t_max, poses[i].temp);
+        t_mean += poses[i].temp / num;
+    }
+    int degree = (t_max - t_min < FIT_TEMP_SPAN_MIN) ? 0 : 2;
+    double coef[3][3];
+    if (fit_gyro(poses, num, t_mean, degree, coef) != 0)
+    {
+        fprintf(stderr, "gyro fit failed\n");
+        return 1;
+    }
+
+    // into the firmware struct, residuals through the firmware code
+    ImuCal cal;
+    imu_cal_init(&cal);
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            cal.accel_matrix[i * 3 + j] = (float32_t)M[i][j];
+        }
+        cal.accel_offset[i] = (float32_t)offset[i];
+    }
+    cal.temp_num = degree > 0 ? IMU_CAL_TEMP_POINTS : 1;
+    for (int k = 0; k < cal.temp_num; k++)
+    {
+        double temp = cal.temp_num > 1 ? t_min + (t_max - t_min) * k / (cal.temp_num - 1) : t_mean;
+        double u = temp - t_mean;
+        cal.temp[k] = (float32_t)temp;
+        for (int i = 0; i < 3; i++)
+        {
+            cal.gyro_bias[k][i] = (float32_t)(coef[i][0] + coef[i][1] * u + coef[i][2] * u * u);
+        }
+    }
+
+    double norm_raw = 0.0, norm_cal = 0.0, gyro_raw = 0.0, gyro_cal = 0.0;
+    for (int i = 0; i < num; i++)
+    {
+        float32_t raw[3], accel[3], gyro_in[3], gyro[3];
+        for (int k = 0; k < 3; k++)
+        {
+            raw[k] = (float32_t)poses[i].accel[k];
+            gyro_in[k] = (float32_t)poses[i].gyro[k];
+        }
+        imu_cal_accel(&cal, raw, accel);
+        imu_cal_gyro(&cal, gyro_in, (float32_t)poses[i].temp, gyro);
+        double n_raw = sqrt(raw[0] * raw[0] + raw[1] * raw[1] + raw[2] * raw[2]) - 1.0;
+        double n_cal = sqrt(accel[0] * accel[0] + accel[1] * accel[1] + accel[2] * accel[2]) - 1.0;
+        norm_raw += n_raw * n_raw / num;
+        norm_cal += n_cal * n_cal / num;
+        for (int k = 0; k < 3; k++)
+        {
+            gyro_raw += gyro_in[k] * gyro_in[k] / (3 * num);
+            gyro_cal += gyro[k] * gyro[k] / (3 * num);
+        }
+    }
+
+    printf("%d poses, %.1f ~ %.1f degC\n", num, t_min, t_max);
+    printf("accel ||a| - 1 g| rms  %.5f g raw, %.5f g calibrated\n", sqrt(norm_raw), sqrt(norm_cal));
+    printf("gyro rate rms          %.6f rad/s raw, %.6f rad/s calibrated\n", sqrt(gyro_raw), sqrt(gyro_cal));
+
+    if (synthetic)
+    {
+        double m_err = 0.0, o_err = 0.0, b_err = 0.0;
+        for (int i = 0; i < 3; i++)
+        {
+            for (int j = 0; j < 3; j++)
+            {
+                m_err = fmax(m_err, fabs(M[i][j] - true_M[i][j]));
+            }
+            o_err = fmax(o_err, fabs(offset[i] - true_offset[i]));
+        }
+        for (double temp = t_min; temp <= t_max; temp += 0.5)
+        {
+            float32_t bias[3];
+            imu_cal_gyro_bias(&cal, (float32_t)temp, bias);
+            for (int i = 0; i < 3; i++)
+            {
+                b_err = fmax(b_err, fabs(bias[i] - true_bias(i, temp)));
+            }
+        }
+        printf("synthetic board: max error matrix %.5f, offset %.5f g, gyro bias %.6f rad/s\n", m_err, o_err, b_err);
+    }
+
+    printf("\n// %d poses, %.1f ~ %.1f degC\n", num, t_min, t_max);
+    printf("ImuCal imu_cal = {\n");
+    printf("    .accel_matrix = {");
+    for (int i = 0; i < 9; i++)
+    {
+        printf("%.6ff%s", cal.accel_matrix[i], i < 8 ? ", " : "},\n");
+    }
+    printf("    .accel_offset = {%.6ff, %.6ff, %.6ff},\n", cal.accel_offset[0], cal.accel_offset[1], cal.accel_offset[2]);
+    printf("    .temp = {");
+    for (int k = 0; k < cal.temp_num; k++)
+    {
+        printf("%.2ff%s", cal.temp[k], k < cal.temp_num - 1 ? ", " : "},\n");
+    }
+    printf("    .gyro_bias = {\n");
+    for (int k = 0; k < cal.temp_num; k++)
+    {
+        printf("        {%.7ff, %.7ff, %.7ff},\n", cal.gyro_bias[k][0], cal.gyro_bias[k][1], cal.gyro_bias[k][2]);
+    }
+    printf("    },\n");
+    printf("    .temp_num = %d,\n", cal.temp_num);
+    printf("};\n");
+    return 0;
+}
@@ -0,0 +1,137 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "quaternion.h"
+
+/*
+ * accuracy and cost of the quaternion integrators used by mahony_update
+ *
+ * usage: integrator_bench [seconds]
+ *
+ * spinning-top motion: constant spin about body z with a 2 Hz wobble about x and y,
+ * the rate is sampled once per step and held, the reference integrates the same held rates
+ * exactly in double, so the error is the integrator alone (no filter correction)
+ */
+
+typedef struct
+{
+    const char *name;
+    void (*step)(Quaternion *q, float32_t w[3], float32_t dt);
+} Integrator;
+
+static const Integrator integrators[] = {
+    {"euler", quat_integrate_euler},
+    {"rk2", quat_integrate_rk2},
+    {"rk4", quat_integrate_rk4},
+    {"exp", quat_integrate_exp},
+};
+#define INTEGRATOR_NUM (sizeof(integrators) / sizeof(integrators[0]))
+
+static const float rates[] = {1000.0f, 500.0f, 250.0f}; // Hz
+static const float spins[] = {10.0f, 25.0f};            // rad/s
+
+static void body_rate(double t, double spin, float32_t w[3])
+{
+    w[0] = (float32_t)(0.8 * sin(2.0 * M_PI * 2.0 * t));
+    w[1] = (float32_t)(0.6 * cos(2.0 * M_PI * 2.0 * t));
+    w[2] = (float32_t)spin;
+}
+
+static void reference_step(double q[4], const float32_t w[3], double dt)
+{
+    double h[3] = {0.5 * w[0] * dt, 0.5 * w[1] * dt, 0.5 * w[2] * dt};
+    double theta = sqrt(h[0] * h[0] + h[1] * h[1] + h[2] * h[2]);
+    double s = theta > 1e-12 ? sin(theta) / theta : 1.0;
+    double d[4] = {cos(theta), h[0] * s, h[1] * s, h[2] * s};
+    double r[4] = {
+        q[0] * d[0] - q[1] * d[1] - q[2] * d[2] - q[3] * d[3],
+        q[0] * d[1] + q[1] * d[0] + q[2] * d[3] - q[3] * d[2],
+        q[0] * d[2] - q[1] * d[3] + q[2] * d[0] + q[3] * d[1],
+        q[0] * d[3] + q[1] * d[2] - q[2] * d[1] + q[3] * d[0],
+    };
+    double n = sqrt(r[0] * r[0] + r[1] * r[1] + r[2] * r[2] + r[3] * r[3]);
+    for (int i = 0; i < 4; i++)
+    {
+        q[i] = r[i] / n;
+    }
+}
+
+static double attitude_error_deg(const Quaternion *q, const double ref[4])
+{
+    // vector part of conj(ref) * q, asin keeps resolution where acos of the dot product loses it
+    double v[3] = {
+        ref[0] * q->q_x - ref[1] * q->q_w - ref[2] * q->q_z + ref[3] * q->q_y,
+        ref[0] * q->q_y + ref[1] * q->q_z - ref[2] * q->q_w - ref[3] * q->q_x,
+        ref[0] * q->q_z - ref[1] * q->q_y + ref[2] * q->q_x - ref[3] * q->q_w,
+    };
+    double norm = sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    return 2.0 * asin(norm > 1.0 ? 1.0 : norm) * 180.0 / M_PI;
+}
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1.0e-9;
+}
+
+int main(int argc, char **argv)
+{
+    double duration = (argc > 1) ? atof(argv[1]) : 60.0;
+    if (duration <= 0.0)
+    {
+        fprintf(stderr, "usage: integrator_bench [seconds]\n");
+        return 1;
+    }
+
+    printf("attitude error after %.0f s of spinning, integrator only\n", duration);
+    printf("%-6s %8s", "spin", "rate");
+    for (size_t k = 0; k < INTEGRATOR_NUM; k++)
+    {
+        printf(" %12s", integrators[k].name);
+    }
+    printf("\n");
+
+    double elapsed[INTEGRATOR_NUM] = {0};
+    long total_steps = 0;
+    for (size_t s = 0; s < sizeof(spins) / sizeof(spins[0]); s++)
+    {
+        for (size_t r = 0; r < sizeof(rates) / sizeof(rates[0]); r++)
+        {
+            float32_t dt = 1.0f / rates[r];
+            long steps = (long)(duration * rates[r]);
+            printf("%4.0f/s %6.0fHz", spins[s], rates[r]);
+
+            for (size_t k = 0; k < INTEGRATOR_NUM; k++)
+            {
+                Quaternion q;
+                quat_identity(&q);
+                double ref[4] = {1.0, 0.0, 0.0, 0.0};
+
+                for (long i = 0; i < steps; i++)
+                {
+                    float32_t w[3];
+                    body_rate(i * (double)dt, spins[s], w);
+                    reference_step(ref, w, dt);
+
+                    double start = now_seconds();
+                    integrators[k].step(&q, w, dt);
+                    elapsed[k] += now_seconds() - start;
+                }
+                printf(" %8.4f deg", attitude_error_deg(&q, ref));
+            }
+            total_steps += steps;
+            printf("\n");
+        }
+    }
+
+    printf("%-15s", "host ns/step");
+    for (size_t k = 0; k < INTEGRATOR_NUM; k++)
+    {
+        printf(" %12.1f", elapsed[k] * 1.0e9 / total_steps);
+    }
+    printf("\n");
+    return 0;
+}
@@ -0,0 +1,182 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "kinematics.h"
+
+/*
+ * checks and timing of Algorithm/Src/kinematics.c
+ *
+ * usage: kine_bench [samples]
+ *
+ * for random chassis velocities (|v| <= 4 m/s, |wz| <= 12 rad/s) on the infantry geometry:
+ *   omni x / mecanum  inverse against the closed form in double, forward(inverse(v)) against v
+ *   swerve            forward(inverse(v)) with the modules settled on their steer angles, a module slower than
+ *                     KINE_SWERVE_HOLD keeps its random heading so the error reaches about that speed,
+ *                     and the largest steer change asked for from a random current angle (90 deg at most)
+ * then the host time per call
+ */
+
+#define BENCH_HALF (0.20f)   // m, infantry wheel offset
+#define BENCH_RADIUS (0.10f) // m
+#define BENCH_V_MAX (4.0f)   // m/s
+#define BENCH_W_MAX (12.0f)  // rad/s
+
+static const float bench_sign[KINE_WHEEL_NUM] = {-1.0f, 1.0f, 1.0f, -1.0f};
+
+static volatile float sink;
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1.0e-9;
+}
+
+static float rand_range(float limit)
+{
+    return ((float)rand() / RAND_MAX * 2.0f - 1.0f) * limit;
+}
+
+static void bench_init(KineInfo *kine, KineType type)
+{
+    KineConfig config = {
+        .type = type,
+        .wheel_radius = BENCH_RADIUS,
+        .half_length = BENCH_HALF,
+        .half_width = BENCH_HALF,
+    };
+    for (int i = 0; i < KINE_WHEEL_NUM; i++)
+    {
+        config.sign[i] = bench_sign[i];
+    }
+    kine_init(kine, &config);
+}
+
+// wheel speeds in double, straight from the wheel layout
+static void reference_inverse(KineType type, const float v[3], double w[KINE_WHEEL_NUM])
+{
+    static const double pos[KINE_WHEEL_NUM][2] = {{1, -1}, {1, 1}, {-1, 1}, {-1, -1}};
+    static const double dir[KINE_WHEEL_NUM][2] = {{1, 1}, {1, -1}, {1, 1}, {1, -1}};
+    for (int i = 0; i < KINE_WHEEL_NUM; i++)
+    {
+        double p_x = pos[i][0] * BENCH_HALF, p_y = pos[i][1] * BENCH_HALF;
+        double surface = dir[i][0] * (v[0] - v[2] * p_y) + dir[i][1] * (v[1] + v[2] * p_x);
+        if (type == KINE_OMNI_X)
+        {
+            surface /= sqrt(2.0);
+        }
+        w[i] = bench_sign[i] * surface / BENCH_RADIUS;
+    }
+}
+
+static void check_wheeled(KineType type, const char *name, int samples)
+{
+    KineInfo kine;
+    bench_init(&kine, type);
+
+    double max_inverse = 0.0, max_round = 0.0;
+    srand(1);
+    for (int n = 0; n < samples; n++)
+    {
+        float v[3] = {rand_range(BENCH_V_MAX), rand_range(BENCH_V_MAX), rand_range(BENCH_W_MAX)};
+        float w[KINE_WHEEL_NUM], back[3];
+        double ref[KINE_WHEEL_NUM];
+
+        kine_inverse(&kine, v, w);
+        reference_inverse(type, v, ref);
+        for (int i = 0; i < KINE_WHEEL_NUM; i++)
+        {
+            max_inverse = fmax(max_inverse, fabs(w[i] - ref[i]));
+        }
+
+        kine_forward(&kine, w, back);
+        for (int i = 0; i < 3; i++)
+        {
+            max_round = fmax(max_round, fabs(back[i] - v[i]));
+        }
+    }
+    printf("%-8s inverse vs closed form max %.2e rad/s   forward(inverse) max %.2e\n", name, max_inverse, max_round);
+}
+
+static void check_swerve(int samples)
+{
+    KineInfo kine;
+    bench_init(&kine, KINE_SWERVE);
+
+    double max_round = 0.0, max_turn = 0.0;
+    srand(1);
+    for (int n = 0; n < samples; n++)
+    {
+        float v[3] = {rand_range(BENCH_V_MAX), rand_range(BENCH_V_MAX), rand_range(BENCH_W_MAX)};
+        float steer_now[KINE_WHEEL_NUM], steer[KINE_WHEEL_NUM], w[KINE_WHEEL_NUM], back[3];
+        for (int i = 0; i < KINE_WHEEL_NUM; i++)
+        {
+            steer_now[i] = rand_range(3.14159265f);
+        }
+
+        // from a random heading the turn stays within 90 deg
+        kine_swerve_inverse(&kine, v, steer_now, w, steer);
+        for (int i = 0; i < KINE_WHEEL_NUM; i++)
+        {
+            double turn = fabs(remainder((double)steer[i] - steer_now[i], 2.0 * M_PI));
+            max_turn = fmax(max_turn, turn);
+        }
+
+        // settled on the asked angles, the module speeds give the chassis velocity back
+        kine_swerve_inverse(&kine, v, steer, w, steer_now);
+        kine_swerve_forward(&kine, w, steer, back);
+        for (int i = 0; i < 3; i++)
+        {
+            max_round = fmax(max_round, fabs(back[i] - v[i]));
+        }
+    }
+    printf("%-8s forward(inverse) max %.2e   largest steer change %.1f deg\n", "swerve", max_round,
+           max_turn * 180.0 / M_PI);
+}
+
+static void speed(int samples)
+{
+    KineInfo omni, swerve;
+    bench_init(&omni, KINE_OMNI_X);
+    bench_init(&swerve, KINE_SWERVE);
+
+    float v[3] = {1.0f, -0.5f, 2.0f}, w[KINE_WHEEL_NUM], back[3];
+    float steer_now[KINE_WHEEL_NUM] = {0.1f, -0.2f, 0.3f, -0.4f}, steer[KINE_WHEEL_NUM];
+
+#define BENCH(label, call, out)                                          \
+    do                                                                   \
+    {                                                                    \
+        float acc = 0.0f;                                                \
+        double start = now_seconds();                                    \
+        for (int n = 0; n < samples; n++)                                \
+        {                                                                \
+            v[0] = (float)(n & 0xFF) * 0.01f;                            \
+            call;                                                        \
+            acc += (out);                                                \
+        }                                                                \
+        double elapsed = now_seconds() - start;                          \
+        sink = acc;                                                      \
+        printf("%-28s %7.2f ns/call\n", label, elapsed * 1.0e9 / samples); \
+    } while (0)
+
+    BENCH("kine_inverse", kine_inverse(&omni, v, w), w[0]);
+    BENCH("kine_forward", kine_forward(&omni, w, back), back[0]);
+    BENCH("kine_swerve_inverse", kine_swerve_inverse(&swerve, v, steer_now, w, steer), w[0] + steer[0]);
+    BENCH("kine_swerve_forward", kine_swerve_forward(&swerve, w, steer_now, back), back[0]);
+}
+
+int main(int argc, char **argv)
+{
+    int samples = argc > 1 ? atoi(argv[1]) : 1000000;
+    if (samples <= 0)
+    {
+        samples = 1000000;
+    }
+
+    check_wheeled(KINE_OMNI_X, "omni x", samples);
+    check_wheeled(KINE_MECANUM, "mecanum", samples);
+    check_swerve(samples);
+    speed(samples);
+    return 0;
+}
@@ -0,0 +1,117 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "pll.h"
+
+/*
+ * velocity from gm6020 feedback frames: reported rpm against the pll observer
+ *
+ * usage: pll_bench [seconds]
+ *
+ * a known rotor trajectory is sampled into the frames the esc sends at 1 kHz (+-50 us jitter):
+ * 13 bit single turn angle and integer rpm, the velocity error is taken against the true velocity at the frame
+ */
+
+#define BENCH_FRAME_DT (1.0e-3)
+#define BENCH_JITTER (50.0e-6)
+#define BENCH_COUNTS (8192.0)
+
+typedef struct
+{
+    const char *name;
+    double v0; // rad/s, constant part
+    double a;  // rad/s, sine amplitude
+    double f;  // Hz
+} Trajectory;
+
+static const Trajectory trajectories[] = {
+    {"creep 0.05 rad/s", 0.05, 0.0, 0.0},
+    {"hold, 0.3 rad/s at 2 Hz", 0.0, 0.3, 2.0},
+    {"track, 8 rad/s at 5 Hz", 0.0, 8.0, 5.0},
+    {"spin 30 rad/s", 30.0, 0.0, 0.0},
+};
+
+static double traj_velocity(const Trajectory *tr, double t)
+{
+    return tr->v0 + tr->a * sin(2.0 * M_PI * tr->f * t);
+}
+
+static double traj_angle(const Trajectory *tr, double t)
+{
+    double angle = tr->v0 * t + 1.0; // start off zero
+    if (tr->f > 0.0)
+    {
+        angle += tr->a / (2.0 * M_PI * tr->f) * (1.0 - cos(2.0 * M_PI * tr->f * t));
+    }
+    return angle;
+}
+
+// rms velocity error after the first 0.5 s, use_pll 0 measures the reported rpm
+static double run(const Trajectory *tr, double seconds, float jerk_noise, int use_rpm, int use_pll, double *max_error)
+{
+    PllInfo pll;
+    pll_init(&pll, jerk_noise);
+    if (!use_rpm)
+    {
+        pll.rpm_noise = 0.0f;
+    }
+    srand(1);
+
+    double t = 0.0, last = 0.0, sum = 0.0;
+    long n = 0;
+    *max_error = 0.0;
+    while (t < seconds)
+    {
+        double angle = fmod(traj_angle(tr, t), 2.0 * M_PI);
+        if (angle < 0.0)
+        {
+            angle += 2.0 * M_PI;
+        }
+        uint16_t raw_angle = (uint16_t)((long)(angle / (2.0 * M_PI) * BENCH_COUNTS) % (long)BENCH_COUNTS);
+        int16_t raw_rpm = (int16_t)lrint(traj_velocity(tr, t) * 60.0 / (2.0 * M_PI));
+
+        // decoded the way motor_data_interpret does
+        float m_angle = (float)raw_angle * 2 * 3.14159265359f / 8192.0f;
+        float m_velocity = (float)raw_rpm * 2 * 3.14159265359f / 60.0f;
+        float estimate = use_pll ? pll_update(&pll, m_angle, m_velocity, (float)(t - last)) : m_velocity;
+
+        if (t > 0.5)
+        {
+            double e = estimate - traj_velocity(tr, t);
+            sum += e * e;
+            n++;
+            if (fabs(e) > *max_error)
+            {
+                *max_error = fabs(e);
+            }
+        }
+
+        last = t;
+        t += BENCH_FRAME_DT + BENCH_JITTER * (2.0 * rand() / RAND_MAX - 1.0);
+    }
+    return sqrt(sum / n);
+}
+
+int main(int argc, char **argv)
+{
+    double seconds = argc > 1 ? atof(argv[1]) : 5.0;
+    static const float jerks[] = {1.0e4f, PLL_JERK_NOISE, 1.0e6f};
+
+    printf("velocity error, rms / max in rad/s, %.0f s per case\n", seconds);
+    for (unsigned i = 0; i < sizeof(trajectories) / sizeof(trajectories[0]); i++)
+    {
+        const Trajectory *tr = &trajectories[i];
+        double max;
+        double rms = run(tr, seconds, 0.0f, 1, 0, &max);
+        printf("%s\n  reported rpm                   %.4f / %.4f\n", tr->name, rms, max);
+        for (unsigned k = 0; k < sizeof(jerks) / sizeof(jerks[0]); k++)
+        {
+            for (int use_rpm = 0; use_rpm < 2; use_rpm++)
+            {
+                rms = run(tr, seconds, jerks[k], use_rpm, 1, &max);
+                printf("  observer jerk %.0e, %-6s  %.4f / %.4f\n", jerks[k], use_rpm ? "+ rpm" : "angle", rms, max);
+            }
+        }
+    }
+    return 0;
+}
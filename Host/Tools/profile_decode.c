@@ -0,0 +1,110 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bsp_dwt.h"
+
+/*
+ * decode a raw dump of profile_table (BSP/Inc/bsp_dwt.h)
+ *
+ * usage: profile_decode <profile.bin> [-h]
+ *   -h  also print the log2 execution histograms
+ *
+ * dump on target: (gdb) dump binary value profile.bin profile_table
+ */
+
+#define HIST_BAR_WIDTH (40)
+
+static double cycles_to_us(double cycles, uint32_t core_clock)
+{
+    return cycles * 1.0e6 / (double)core_clock;
+}
+
+static void print_histogram(const TaskProfile *task)
+{
+    uint32_t peak = 0;
+    for (int k = 0; k < PROFILE_HIST_BINS; k++)
+    {
+        if (task->hist[k] > peak)
+        {
+            peak = task->hist[k];
+        }
+    }
+
+    for (int k = 0; k < PROFILE_HIST_BINS; k++)
+    {
+        if (task->hist[k] == 0)
+        {
+            continue;
+        }
+        int width = (int)((uint64_t)task->hist[k] * HIST_BAR_WIDTH / peak);
+        printf("    %10u ~ %10u cycles %10u |", k ? 1u << k : 0u, (uint32_t)((2ull << k) - 1), task->hist[k]);
+        for (int i = 0; i < width; i++)
+        {
+            putchar('#');
+        }
+        putchar('\n');
+    }
+}
+
+int main(int argc, char **argv)
+{
+    static const char *names[PROFILE_TASK_NUM] = PROFILE_TASK_NAMES;
+    ProfileTable table;
+
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: profile_decode <profile.bin> [-h]\n");
+        return 1;
+    }
+    int show_hist = (argc > 2 && strcmp(argv[2], "-h") == 0);
+
+    FILE *file = fopen(argv[1], "rb");
+    if (file == NULL)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+    size_t size = fread(&table, 1, sizeof(table), file);
+    fclose(file);
+
+    if (size != sizeof(table) || table.magic != PROFILE_MAGIC)
+    {
+        fprintf(stderr, "%s: not a profile_table dump (%zu bytes, expected %zu)\n", argv[1], size, sizeof(table));
+        return 1;
+    }
+    if (table.version != PROFILE_VERSION || table.task_num != PROFILE_TASK_NUM)
+    {
+        fprintf(stderr, "%s: version %u with %u tasks, decoder expects version %u with %u tasks\n",
+                argv[1], table.version, table.task_num, PROFILE_VERSION, PROFILE_TASK_NUM);
+        return 1;
+    }
+
+    uint32_t clock = table.core_clock;
+    printf("core clock %u Hz\n", clock);
+    printf("%-6s %10s %10s %10s %10s %10s %10s %10s\n",
+           "task", "count", "min(us)", "mean(us)", "max(us)", "period(us)", "jitter(us)", "load(%)");
+
+    for (int i = 0; i < PROFILE_TASK_NUM; i++)
+    {
+        const TaskProfile *task = &table.task[i];
+        if (task->count == 0)
+        {
+            printf("%-6s %10u\n", names[i], 0u);
+            continue;
+        }
+
+        double mean = (double)task->exec_sum / task->count;
+        double period = task->count > 1 ? (double)task->period_sum / (task->count - 1) : 0.0;
+        double jitter = task->count > 1 ? (double)(task->period_max - task->period_min) : 0.0;
+        printf("%-6s %10u %10.2f %10.2f %10.2f %10.2f %10.2f %10.2f\n", names[i], task->count,
+               cycles_to_us(task->exec_min, clock), cycles_to_us(mean, clock), cycles_to_us(task->exec_max, clock),
+               cycles_to_us(period, clock), cycles_to_us(jitter, clock), period > 0.0 ? mean / period * 100.0 : 0.0);
+
+        if (show_hist)
+        {
+            print_histogram(task);
+        }
+    }
+
+    return 0;
+}
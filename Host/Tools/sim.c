@@ -0,0 +1,357 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "main.h"
+#include "pid.h"
+#include "dbus.h"
+#include "motor.h"
+#include "body.h"
+#include "neck.h"
+#include "head.h"
+#include "sim_plant.h"
+
+/*
+ * closed-loop simulation of body_task / neck_task / head_task against sim_plant
+ *
+ * usage: sim <yaw|pitch|chassis|shoot> [-t] [pid_name.field=value ...]
+ *   -t                    print the trace as csv (time, target, measure, current)
+ *   pid_name.field=value  override a PidInfo in controller.c before the run,
+ *                         e.g. pid_yaw_v2v.kp=5 pid_yaw_p2v.kp=12
+ */
+
+#ifndef PI
+#define PI (3.14159265358979f)
+#endif
+
+#define SIM_SUBSTEPS (10)       // plant steps per 1 ms control tick
+#define SIM_BODY_DIVIDER (8)    // body_task at 125 Hz
+#define SIM_STEP_TICK (100)     // ms, when the input step starts
+#define SIM_MAX_TICKS (5000)    // ms, longest scenario
+#define SIM_SETTLE_BAND (0.02f) // settling band, fraction of the step size
+
+// pid tables in controller.c
+extern PidInfo pid_fr_v2c, pid_fl_v2c, pid_bl_v2c, pid_br_v2c;
+extern PidInfo pid_pitch_v2v, pid_pitch_p2v;
+extern PidInfo pid_friction_l_v2c, pid_friction_r_v2c, pid_trigger_v2c;
+extern PidInfo pid_yaw_v2v, pid_yaw_p2v;
+
+typedef struct
+{
+    const char *name;
+    PidInfo *pid;
+} PidEntry;
+
+static const PidEntry pid_table[] = {
+    {"pid_fr_v2c", &pid_fr_v2c},
+    {"pid_fl_v2c", &pid_fl_v2c},
+    {"pid_bl_v2c", &pid_bl_v2c},
+    {"pid_br_v2c", &pid_br_v2c},
+    {"pid_pitch_v2v", &pid_pitch_v2v},
+    {"pid_pitch_p2v", &pid_pitch_p2v},
+    {"pid_friction_l_v2c", &pid_friction_l_v2c},
+    {"pid_friction_r_v2c", &pid_friction_r_v2c},
+    {"pid_trigger_v2c", &pid_trigger_v2c},
+    {"pid_yaw_v2v", &pid_yaw_v2v},
+    {"pid_yaw_p2v", &pid_yaw_p2v},
+};
+
+typedef struct
+{
+    const char *name;
+    uint32_t ticks;                      // ms
+    void (*input)(uint32_t tick);        // set dbus_data for this tick
+    float (*measure)(void);              // controlled output
+    float (*peak_current)(void);         // largest |current| of the involved motors
+    float target;                        // final target, filled by prepare
+    void (*prepare)(void *scenario);     // compute the target the tasks will integrate to
+} Scenario;
+
+/*
+ **************************************************************************
+ * scenarios
+ **************************************************************************
+ */
+#define YAW_STEP_TICKS (80)   // rs_y = -1 for 80 ms
+#define PITCH_STEP_TICKS (50) // rs_x = -1 for 50 ms
+
+static void yaw_input(uint32_t tick)
+{
+    dbus_data.rs_y = (tick >= SIM_STEP_TICK && tick < SIM_STEP_TICK + YAW_STEP_TICKS) ? -1.0f : 0.0f;
+}
+
+static float yaw_measure(void)
+{
+    return sim_plant_yaw_angle();
+}
+
+static float yaw_current(void)
+{
+    return fabsf(sim_plant.rotor[GIMBAL_YAW].current);
+}
+
+static void yaw_prepare(void *scenario)
+{
+    // same float accumulation as neck_task
+    float target = 0.0f;
+    for (int i = 0; i < YAW_STEP_TICKS; i++)
+    {
+        target += (1.0f / 1000.0f) * 2 * PI;
+    }
+    ((Scenario *)scenario)->target = target;
+}
+
+static void pitch_input(uint32_t tick)
+{
+    dbus_data.rs_x = (tick >= SIM_STEP_TICK && tick < SIM_STEP_TICK + PITCH_STEP_TICKS) ? -1.0f : 0.0f;
+}
+
+static float pitch_measure(void)
+{
+    return sim_plant_pitch_angle();
+}
+
+static float pitch_current(void)
+{
+    return fabsf(sim_plant.rotor[GIMBAL_PITCH].current);
+}
+
+static void pitch_prepare(void *scenario)
+{
+    // same float accumulation as head_task
+    float half_angle = (2190.f - 670.0f) / 8192.0f / 2.0f * 2 * PI;
+    float target = 0.0f;
+    for (int i = 0; i < PITCH_STEP_TICKS; i++)
+    {
+        target += (half_angle / 1000.0f) * 6.0f;
+    }
+    ((Scenario *)scenario)->target = target;
+}
+
+static void chassis_input(uint32_t tick)
+{
+    dbus_data.ls_x = (tick >= SIM_STEP_TICK) ? 0.5f : 0.0f; // 1 m/s forward
+}
+
+static float chassis_measure(void)
+{
+    return sim_plant.chassis_v[0];
+}
+
+static float chassis_current(void)
+{
+    float peak = 0.0f;
+    for (int i = CHASSIS_FR; i <= CHASSIS_BR; i++)
+    {
+        peak = fmaxf(peak, fabsf(sim_plant.rotor[i].current));
+    }
+    return peak;
+}
+
+static void chassis_prepare(void *scenario)
+{
+    ((Scenario *)scenario)->target = 1.0f;
+}
+
+static void shoot_input(uint32_t tick)
+{
+    dbus_data.wheel = (tick >= SIM_STEP_TICK) ? 1684 : 1024;
+}
+
+static float shoot_measure(void)
+{
+    return sim_plant.rotor[FRICTION_R].velocity;
+}
+
+static float shoot_current(void)
+{
+    return fmaxf(fabsf(sim_plant.rotor[FRICTION_L].current), fabsf(sim_plant.rotor[FRICTION_R].current));
+}
+
+static void shoot_prepare(void *scenario)
+{
+    ((Scenario *)scenario)->target = 300.0f;
+}
+
+static Scenario scenarios[] = {
+    {"yaw", 1500, yaw_input, yaw_measure, yaw_current, 0.0f, yaw_prepare},
+    {"pitch", 1500, pitch_input, pitch_measure, pitch_current, 0.0f, pitch_prepare},
+    {"chassis", 2000, chassis_input, chassis_measure, chassis_current, 0.0f, chassis_prepare},
+    {"shoot", 2000, shoot_input, shoot_measure, shoot_current, 0.0f, shoot_prepare},
+};
+
+/*
+ **************************************************************************
+ * helper functions
+ **************************************************************************
+ */
+static int apply_override(const char *arg)
+{
+    char name[32];
+    char field[16];
+    float value;
+    if (sscanf(arg, "%31[^.].%15[^=]=%f", name, field, &value) != 3)
+    {
+        return -1;
+    }
+
+    for (size_t i = 0; i < sizeof(pid_table) / sizeof(pid_table[0]); i++)
+    {
+        if (strcmp(pid_table[i].name, name) != 0)
+        {
+            continue;
+        }
+        PidInfo *pid = pid_table[i].pid;
+        if (strcmp(field, "kp") == 0)
+            pid->kp = value;
+        else if (strcmp(field, "ki") == 0)
+            pid->ki = value;
+        else if (strcmp(field, "kd") == 0)
+            pid->kd = value;
+        else if (strcmp(field, "i_limit") == 0)
+            pid->i_limit = value;
+        else if (strcmp(field, "out_limit") == 0)
+            pid->out_limit = value;
+        else
+            return -1;
+        return 0;
+    }
+    return -1;
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: sim <yaw|pitch|chassis|shoot> [-t] [pid_name.field=value ...]\n");
+    exit(1);
+}
+
+/*
+ **************************************************************************
+ * main loop
+ **************************************************************************
+ */
+int main(int argc, char **argv)
+{
+    static float trace_measure[SIM_MAX_TICKS];
+    static float trace_current[SIM_MAX_TICKS];
+
+    if (argc < 2)
+    {
+        usage();
+    }
+
+    Scenario *scenario = NULL;
+    for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++)
+    {
+        if (strcmp(argv[1], scenarios[i].name) == 0)
+        {
+            scenario = &scenarios[i];
+        }
+    }
+    if (scenario == NULL)
+    {
+        usage();
+    }
+
+    int print_trace = 0;
+    for (int i = 2; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-t") == 0)
+        {
+            print_trace = 1;
+        }
+        else if (apply_override(argv[i]) != 0)
+        {
+            fprintf(stderr, "bad override: %s\n", argv[i]);
+            usage();
+        }
+    }
+
+    // neutral remote, robot enabled
+    motor_init();
+    sim_plant_init();
+    memset(&dbus_data, 0, sizeof(dbus_data));
+    dbus_data.sw1 = SW_MID;
+    dbus_data.wheel = 1024;
+    scenario->prepare(scenario);
+    sim_plant_send_feedback();
+
+    clock_t wall_start = clock();
+    float dt = 1.0e-3f / SIM_SUBSTEPS;
+    for (uint32_t tick = 0; tick < scenario->ticks; tick++)
+    {
+        scenario->input(tick);
+        dbus_data_publish(&dbus_data);
+
+        // tasks run on the feedback received during the last millisecond
+        neck_task();
+        head_task();
+        if (tick % SIM_BODY_DIVIDER == 0)
+        {
+            body_task();
+        }
+        motor_flush_commands();
+
+        for (int i = 0; i < SIM_SUBSTEPS; i++)
+        {
+            sim_plant_step(dt);
+        }
+        sim_plant_send_feedback();
+        host_advance_tick(1);
+
+        trace_measure[tick] = scenario->measure();
+        trace_current[tick] = scenario->peak_current();
+    }
+    double wall = (double)(clock() - wall_start) / CLOCKS_PER_SEC;
+
+    // step response metrics
+    float initial = trace_measure[SIM_STEP_TICK - 1];
+    float step = scenario->target - initial;
+    float peak = initial, peak_current = 0.0f;
+    int rise_10 = -1, rise_90 = -1, settle = SIM_STEP_TICK;
+    for (uint32_t tick = SIM_STEP_TICK; tick < scenario->ticks; tick++)
+    {
+        float progress = (trace_measure[tick] - initial) / step;
+        if (rise_10 < 0 && progress >= 0.1f)
+        {
+            rise_10 = tick;
+        }
+        if (rise_90 < 0 && progress >= 0.9f)
+        {
+            rise_90 = tick;
+        }
+        if ((trace_measure[tick] - peak) * step > 0.0f)
+        {
+            peak = trace_measure[tick];
+        }
+        if (fabsf(trace_measure[tick] - scenario->target) > SIM_SETTLE_BAND * fabsf(step))
+        {
+            settle = tick + 1;
+        }
+        peak_current = fmaxf(peak_current, trace_current[tick]);
+    }
+    float overshoot = fmaxf(0.0f, (peak - scenario->target) / step) * 100.0f;
+    float final = trace_measure[scenario->ticks - 1];
+
+    if (print_trace)
+    {
+        printf("time,target,measure,current\n");
+        for (uint32_t tick = 0; tick < scenario->ticks; tick++)
+        {
+            printf("%.3f,%.5f,%.5f,%.3f\n", tick * 1.0e-3f,
+                   tick < SIM_STEP_TICK ? initial : scenario->target, trace_measure[tick], trace_current[tick]);
+        }
+    }
+
+    fprintf(print_trace ? stderr : stdout,
+            "%s: target %.4f final %.4f rise %d ms overshoot %.1f %% settle(2%%) %d ms peak current %.2f A"
+            " | %.2f s simulated in %.3f s wall\n",
+            scenario->name, scenario->target, final,
+            (rise_10 >= 0 && rise_90 >= 0) ? rise_90 - rise_10 : -1,
+            overshoot,
+            settle < (int)scenario->ticks ? settle - SIM_STEP_TICK : -1,
+            peak_current, scenario->ticks * 1.0e-3f, wall);
+
+    return 0;
+}
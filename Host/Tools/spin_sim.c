@@ -0,0 +1,174 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "main.h"
+#include "dbus.h"
+#include "motor.h"
+#include "body.h"
+#include "neck.h"
+#include "head.h"
+#include "sim_plant.h"
+
+/*
+ * spinning top mode against sim_plant: world frame gimbal yaw and gimbal relative driving
+ *
+ * usage: spin_sim [-t]   -t dumps time, chassis rate, gimbal heading error, drive heading error as csv
+ *
+ * the tasks run as in sim.c, the imu is the ideal chassis imu of sim_plant.c:
+ *   0 ~ 0.3 s  idle
+ *   0.3 s      sw2 down, spin up
+ *   1.5 ~ 3 s  steady spin, standing
+ *   3 ~ 4.5 s  steady spin, left stick forward at SPIN_SIM_VX in the gimbal frame
+ *   4.5 s      sw2 mid, spin down and hand back to the encoder frame
+ * the gimbal heading error is the world yaw against the heading held since the start, the drive heading error
+ * the ground track against the gimbal heading, both worst case and rms per phase, 6000 ms in all
+ */
+
+#ifndef PI
+#define PI (3.14159265358979f)
+#endif
+
+#define SPIN_SIM_SUBSTEPS (10)  // plant steps per 1 ms
+#define SPIN_SIM_DIVIDER (8)    // body_task at 125 Hz
+#define SPIN_SIM_TICKS (6000)   // ms
+#define SPIN_SIM_ON (300)       // ms, sw2 down
+#define SPIN_SIM_STEADY (1500)  // ms, spin up done
+#define SPIN_SIM_DRIVE (3000)   // ms, left stick forward
+#define SPIN_SIM_OFF (4500)     // ms, sw2 back to mid
+#define SPIN_SIM_VX (1.0f)      // m/s, ls_x 0.5
+#define SPIN_SIM_TRACK (0.5f)   // m/s, slower ground speeds have no meaningful track
+#define SPIN_SIM_STILL (0.1f)   // rad/s, chassis counted as stopped, as WORLD_YAW_RATE in neck.c
+
+typedef struct
+{
+    const char *name;
+    uint32_t start, end; // ms
+    float max;           // rad
+    float sum_sq;
+    uint32_t count;
+} SpinPhase;
+
+static inline float wrap_pi(float x)
+{
+    return x - 2.0f * PI * floorf((x + PI) / (2.0f * PI));
+}
+
+static void phase_add(SpinPhase *phase, uint32_t tick, float error)
+{
+    if (tick < phase->start || tick >= phase->end)
+    {
+        return;
+    }
+    phase->max = fmaxf(phase->max, fabsf(error));
+    phase->sum_sq += error * error;
+    phase->count++;
+}
+
+static void phase_print(const SpinPhase *phase, const char *label)
+{
+    float rms = phase->count > 0 ? sqrtf(phase->sum_sq / phase->count) : 0.0f;
+    printf("%-22s %-16s max %6.2f mrad  rms %6.2f mrad\n", phase->name, label, phase->max * 1.0e3f, rms * 1.0e3f);
+}
+
+int main(int argc, char **argv)
+{
+    int trace = argc > 1 && strcmp(argv[1], "-t") == 0;
+
+    SpinPhase heading[] = {
+        {"spin up", SPIN_SIM_ON, SPIN_SIM_STEADY},
+        {"steady spin", SPIN_SIM_STEADY, SPIN_SIM_DRIVE},
+        {"steady spin, driving", SPIN_SIM_DRIVE, SPIN_SIM_OFF},
+        {"spin down", SPIN_SIM_OFF, SPIN_SIM_TICKS},
+    };
+    SpinPhase track = {"steady spin, driving", SPIN_SIM_DRIVE + 500, SPIN_SIM_OFF};
+    float w_peak = 0.0f, speed_sum = 0.0f;
+    uint32_t speed_count = 0, handback = 0;
+
+    // neutral remote, robot enabled
+    motor_init();
+    sim_plant_init();
+    memset(&dbus_data, 0, sizeof(dbus_data));
+    dbus_data.sw1 = SW_MID;
+    dbus_data.sw2 = SW_MID;
+    dbus_data.wheel = 1024;
+    sim_plant_send_feedback();
+
+    if (trace)
+    {
+        printf("t,wz,heading_err,track_err\n");
+    }
+
+    float dt = 1.0e-3f / SPIN_SIM_SUBSTEPS;
+    for (uint32_t tick = 0; tick < SPIN_SIM_TICKS; tick++)
+    {
+        dbus_data.sw2 = (tick >= SPIN_SIM_ON && tick < SPIN_SIM_OFF) ? SW_DOWN : SW_MID;
+        dbus_data.ls_x = (tick >= SPIN_SIM_DRIVE && tick < SPIN_SIM_OFF) ? 0.5f * SPIN_SIM_VX : 0.0f;
+        dbus_data_publish(&dbus_data);
+
+        neck_task();
+        head_task();
+        if (tick % SPIN_SIM_DIVIDER == 0)
+        {
+            body_task();
+        }
+        motor_flush_commands();
+
+        for (int i = 0; i < SPIN_SIM_SUBSTEPS; i++)
+        {
+            sim_plant_step(dt);
+        }
+        sim_plant_send_feedback();
+        host_advance_tick(1);
+
+        // gimbal heading, the target never moved from the start
+        float error = wrap_pi(sim_plant.gimbal_yaw);
+        for (unsigned i = 0; i < sizeof(heading) / sizeof(heading[0]); i++)
+        {
+            phase_add(&heading[i], tick, error);
+        }
+
+        // ground track in the world frame against the gimbal heading
+        float *cv = sim_plant.chassis_v;
+        float c = cosf(sim_plant.chassis_yaw), s = sinf(sim_plant.chassis_yaw);
+        float v_world[2] = {c * cv[0] - s * cv[1], s * cv[0] + c * cv[1]};
+        float speed = sqrtf(v_world[0] * v_world[0] + v_world[1] * v_world[1]);
+        float track_error = speed > SPIN_SIM_TRACK ? wrap_pi(atan2f(v_world[1], v_world[0]) - sim_plant.gimbal_yaw)
+                                                   : 0.0f;
+        if (speed > SPIN_SIM_TRACK)
+        {
+            phase_add(&track, tick, track_error);
+        }
+        if (tick >= track.start && tick < track.end)
+        {
+            speed_sum += speed;
+            speed_count++;
+        }
+
+        w_peak = fmaxf(w_peak, cv[2]);
+        if (tick >= SPIN_SIM_OFF && handback == 0 && fabsf(cv[2]) < SPIN_SIM_STILL)
+        {
+            handback = tick;
+        }
+
+        if (trace)
+        {
+            printf("%.3f,%.3f,%.5f,%.5f\n", (tick + 1) * 1.0e-3f, cv[2], error, track_error);
+        }
+    }
+
+    if (trace)
+    {
+        return 0;
+    }
+
+    printf("spin to %.2f rad/s, %.2f m/s ground speed while driving, chassis below %.1f rad/s %d ms after sw2 mid\n",
+           w_peak, speed_count > 0 ? speed_sum / speed_count : 0.0f, SPIN_SIM_STILL,
+           handback ? (int)(handback - SPIN_SIM_OFF) : -1);
+    for (unsigned i = 0; i < sizeof(heading) / sizeof(heading[0]); i++)
+    {
+        phase_print(&heading[i], "gimbal heading");
+    }
+    phase_print(&track, "drive heading");
+    return 0;
+}
@@ -0,0 +1,262 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "mahony.h"
+
+/*
+ * mahony roll / pitch error on an accelerating, spinning chassis
+ *
+ * usage: tilt_bench [phase_seconds]
+ *
+ * three phases of equal length: strafing with hard braking, spinning, spinning while strafing,
+ * the imu sits IMU_OFFSET off the spin axis so spinning adds a centripetal term,
+ * the gimbal nods in pitch throughout so there is tilt to track,
+ * runs the imu tuning with a fixed kp and with the accelerometer trust bands,
+ * reports rms / max tilt error and the mean effective kp per phase
+ *
+ * pass: the trust bands cut the rms tilt error below the fixed kp one in every phase, exits 1 otherwise
+ */
+
+#define BENCH_RATE (1000) // Hz
+#define PHASE_NUM (3)
+
+#define GYRO_SIGMA (0.003)  // rad/s, per sample white noise
+#define ACCEL_SIGMA (0.003) // g, per sample white noise
+#define GRAVITY (9.81)      // m/s^2
+#define SPIN_RATE (6.0)     // rad/s
+#define SPIN_RAMP (1.0)     // s, spin up
+#define NOD_AMPLITUDE (0.1) // rad, gimbal pitch
+#define NOD_FREQ (0.8)      // Hz
+
+static const double imu_offset[3] = {0.12, 0.05, 0.0}; // m, body frame, from the spin axis
+static const char *phase_names[PHASE_NUM] = {"strafe", "spin", "spin+strafe"};
+
+typedef struct
+{
+    const char *name;
+    MahonyFilter filter;
+
+    double tilt_sum2[PHASE_NUM];
+    double tilt_max[PHASE_NUM];
+    double kp_sum[PHASE_NUM];
+    long count[PHASE_NUM];
+} TiltRun;
+
+/*
+ **************************************************************************
+ * synthetic truth, double precision
+ **************************************************************************
+ */
+static double gauss(void)
+{
+    // box-muller
+    double u1 = (rand() + 1.0) / (RAND_MAX + 2.0);
+    double u2 = (rand() + 1.0) / (RAND_MAX + 2.0);
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+static double smooth_square(double t, double freq)
+{
+    // square wave with ~50 ms edges
+    return tanh(10.0 * sin(2.0 * M_PI * freq * t));
+}
+
+// chassis yaw rate, rad/s, ramps up at the start of the spin phase
+static double spin_rate(double t, double phase)
+{
+    if (t < phase)
+    {
+        return 0.0;
+    }
+    double ramp = (t - phase) / SPIN_RAMP;
+    return SPIN_RATE * (ramp < 1.0 ? ramp : 1.0);
+}
+
+// chassis yaw, rad, integral of spin_rate
+static double spin_angle(double t, double phase)
+{
+    if (t < phase)
+    {
+        return 0.0;
+    }
+    double s = t - phase;
+    if (s < SPIN_RAMP)
+    {
+        return 0.5 * SPIN_RATE * s * s / SPIN_RAMP;
+    }
+    return SPIN_RATE * (s - 0.5 * SPIN_RAMP);
+}
+
+// world frame linear acceleration of the chassis, m/s^2
+static void chassis_accel(double t, double phase, double a[3])
+{
+    a[0] = a[1] = a[2] = 0.0;
+    if (t < phase || t >= 2.0 * phase)
+    {
+        // strafing left / right at 0.6 g, braking at 1 g for 0.3 s every 4 s
+        a[1] = 0.6 * GRAVITY * smooth_square(t, 0.5);
+        if (fmod(t, 4.0) < 0.3)
+        {
+            a[0] = -1.0 * GRAVITY;
+        }
+    }
+}
+
+// truth attitude: chassis yaw, then the gimbal nodding in pitch
+static void truth_attitude(double t, double phase, double q[4])
+{
+    double yaw = spin_angle(t, phase);
+    double pitch = NOD_AMPLITUDE * sin(2.0 * M_PI * NOD_FREQ * t);
+    q[0] = cos(0.5 * yaw) * cos(0.5 * pitch);
+    q[1] = -sin(0.5 * yaw) * sin(0.5 * pitch);
+    q[2] = cos(0.5 * yaw) * sin(0.5 * pitch);
+    q[3] = sin(0.5 * yaw) * cos(0.5 * pitch);
+}
+
+// body rates of truth_attitude: Ry(pitch)^T [0, 0, yaw_rate] + [0, pitch_rate, 0]
+static void body_rate(double t, double phase, double w[3])
+{
+    double yaw_rate = spin_rate(t, phase);
+    double pitch = NOD_AMPLITUDE * sin(2.0 * M_PI * NOD_FREQ * t);
+    double pitch_rate = NOD_AMPLITUDE * 2.0 * M_PI * NOD_FREQ * cos(2.0 * M_PI * NOD_FREQ * t);
+    w[0] = -sin(pitch) * yaw_rate;
+    w[1] = pitch_rate;
+    w[2] = cos(pitch) * yaw_rate;
+}
+
+static void truth_to_body(const double q[4], const double v[3], double out[3])
+{
+    // R^T v
+    double w = q[0], x = q[1], y = q[2], z = q[3];
+    double R[3][3] = {
+        {1 - 2 * (y * y + z * z), 2 * (x * y - w * z), 2 * (x * z + w * y)},
+        {2 * (x * y + w * z), 1 - 2 * (x * x + z * z), 2 * (y * z - w * x)},
+        {2 * (x * z - w * y), 2 * (y * z + w * x), 1 - 2 * (x * x + y * y)},
+    };
+    for (int i = 0; i < 3; i++)
+    {
+        out[i] = R[0][i] * v[0] + R[1][i] * v[1] + R[2][i] * v[2];
+    }
+}
+
+static void cross(const double a[3], const double b[3], double out[3])
+{
+    out[0] = a[1] * b[2] - a[2] * b[1];
+    out[1] = a[2] * b[0] - a[0] * b[2];
+    out[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+static double tilt_error(const Quaternion *q, const double truth[4])
+{
+    // angle between the estimated and true gravity direction in the body frame
+    static const double up[3] = {0.0, 0.0, 1.0};
+    double estimate[4] = {q->q_w, q->q_x, q->q_y, q->q_z};
+    double g_est[3], g_true[3], c[3];
+    truth_to_body(estimate, up, g_est);
+    truth_to_body(truth, up, g_true);
+    cross(g_est, g_true, c);
+    double dot = g_est[0] * g_true[0] + g_est[1] * g_true[1] + g_est[2] * g_true[2];
+    return atan2(sqrt(c[0] * c[0] + c[1] * c[1] + c[2] * c[2]), dot);
+}
+
+/*
+ **************************************************************************
+ * main loop
+ **************************************************************************
+ */
+int main(int argc, char **argv)
+{
+    double phase = (argc > 1) ? atof(argv[1]) : 20.0;
+    if (phase <= 0.0)
+    {
+        fprintf(stderr, "usage: tilt_bench [phase_seconds]\n");
+        return 1;
+    }
+
+    // same tuning as Device/Src/imu.c
+    TiltRun runs[2];
+    memset(runs, 0, sizeof(runs));
+    runs[0].name = "fixed kp";
+    runs[1].name = "trust";
+    for (int r = 0; r < 2; r++)
+    {
+        mahony_init(&runs[r].filter, 0.6f, 0.0f, 0.0f, BENCH_RATE);
+        runs[r].filter.integrator = MAHONY_INTEGRATOR_EXP;
+    }
+    runs[1].filter.accel_band = 0.1f;
+    runs[1].filter.rate_band = 2.0f;
+
+    srand(11);
+    double dt = 1.0 / BENCH_RATE;
+    long steps = (long)(PHASE_NUM * phase * BENCH_RATE);
+    for (long k = 0; k < steps; k++)
+    {
+        double t = k * dt;
+        int p = (int)(t / phase);
+        double q[4], w[3], w_dot[3], w_next[3], a_world[3], a_body[3];
+        truth_attitude(t, phase, q);
+        body_rate(t, phase, w);
+        body_rate(t + dt, phase, w_next);
+        for (int i = 0; i < 3; i++)
+        {
+            w_dot[i] = (w_next[i] - w[i]) / dt;
+        }
+
+        // specific force at the imu: R^T (a + g) + w x (w x r) + w_dot x r, in g
+        chassis_accel(t, phase, a_world);
+        a_world[2] += GRAVITY;
+        truth_to_body(q, a_world, a_body);
+        double wr[3], centripetal[3], tangential[3];
+        cross(w, imu_offset, wr);
+        cross(w, wr, centripetal);
+        cross(w_dot, imu_offset, tangential);
+
+        // the filter integrates to t + dt
+        double q_next[4];
+        truth_attitude(t + dt, phase, q_next);
+
+        float32_t gyro[3], accel[3];
+        for (int i = 0; i < 3; i++)
+        {
+            double a = (a_body[i] + centripetal[i] + tangential[i]) / GRAVITY;
+            gyro[i] = (float32_t)(0.5 * (w[i] + w_next[i]) + GYRO_SIGMA * gauss()); // mean rate over the step
+            accel[i] = (float32_t)(a + ACCEL_SIGMA * gauss());
+        }
+
+        for (int r = 0; r < 2; r++)
+        {
+            TiltRun *run = &runs[r];
+            mahony_update(&run->filter, gyro, accel);
+
+            double tilt = tilt_error(&run->filter.q, q_next) * 180.0 / M_PI;
+            run->tilt_sum2[p] += tilt * tilt;
+            run->tilt_max[p] = fmax(run->tilt_max[p], tilt);
+            run->kp_sum[p] += run->filter.kp_effective;
+            run->count[p]++;
+        }
+    }
+
+    printf("tilt error, %.0f s per phase, imu %.2f m off the spin axis, spin %.1f rad/s\n",
+           phase, sqrt(imu_offset[0] * imu_offset[0] + imu_offset[1] * imu_offset[1]), SPIN_RATE);
+    printf("%-12s %-10s %12s %12s %10s\n", "phase", "filter", "rms(deg)", "max(deg)", "mean kp");
+    int fail = 0;
+    for (int p = 0; p < PHASE_NUM; p++)
+    {
+        double rms[2];
+        for (int r = 0; r < 2; r++)
+        {
+            TiltRun *run = &runs[r];
+            rms[r] = sqrt(run->tilt_sum2[p] / run->count[p]);
+            printf("%-12s %-10s %12.3f %12.3f %10.3f\n", phase_names[p], run->name, rms[r], run->tilt_max[p],
+                   run->kp_sum[p] / run->count[p]);
+        }
+        if (!(rms[1] < rms[0]))
+        {
+            printf("FAIL: %s, trust rms not below fixed kp\n", phase_names[p]);
+            fail = 1;
+        }
+    }
+    printf("%s\n", fail ? "FAIL" : "pass");
+    return fail;
+}
@@ -0,0 +1,176 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "arm_math.h"
+#include "fast_trig.h"
+
+/*
+ * accuracy and speed of Algorithm/Src/fast_trig.c against double precision libm,
+ * single precision libm and the arm_sin_cos_f32 interface
+ *
+ * usage: trig_bench [samples]
+ *
+ * timings are host timings: the arm_math shim wraps libm here, so they only rank the kernels,
+ * target cycle counts come from the dwt profiler around the imu stage
+ */
+
+#define BENCH_SAMPLES (1000000)
+
+typedef struct
+{
+    double max_ulp;
+    double max_abs;
+    float worst_input;
+} ErrorStat;
+
+static double ulp_error(float value, double reference)
+{
+    float ref = (float)reference;
+    float ulp = nextafterf(fabsf(ref), INFINITY) - fabsf(ref);
+    return fabs((double)value - reference) / ulp;
+}
+
+static void error_add(ErrorStat *stat, float input, float value, double reference)
+{
+    double ulp = ulp_error(value, reference);
+    double abs_error = fabs((double)value - reference);
+    if (ulp > stat->max_ulp)
+    {
+        stat->max_ulp = ulp;
+        stat->worst_input = input;
+    }
+    if (abs_error > stat->max_abs)
+    {
+        stat->max_abs = abs_error;
+    }
+}
+
+static void error_print(const char *name, const char *range, ErrorStat *stat)
+{
+    printf("%-14s %-22s max %6.2f ulp  max abs %.3e  (worst at %.9g)\n",
+           name, range, stat->max_ulp, stat->max_abs, stat->worst_input);
+}
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1.0e-9;
+}
+
+/*
+ **************************************************************************
+ * accuracy
+ **************************************************************************
+ */
+static void accuracy(int samples)
+{
+    ErrorStat sin_stat = {0}, cos_stat = {0}, wide_stat = {0};
+    for (int i = 0; i <= samples; i++)
+    {
+        float x = -PI + 2.0f * PI * i / samples;
+        float s, c;
+        fast_sin_cos(x, &s, &c);
+        error_add(&sin_stat, x, s, sin((double)x));
+        error_add(&cos_stat, x, c, cos((double)x));
+
+        float w = -1.0e4f + 2.0e4f * i / samples;
+        fast_sin_cos(w, &s, &c);
+        error_add(&wide_stat, w, s, sin((double)w));
+        error_add(&wide_stat, w, c, cos((double)w));
+    }
+    error_print("fast_sin", "[-pi, pi]", &sin_stat);
+    error_print("fast_cos", "[-pi, pi]", &cos_stat);
+    printf("%-14s %-22s max abs %.3e\n", "fast_sin_cos", "[-1e4, 1e4]", wide_stat.max_abs);
+
+    // atan2 on circles of several radii
+    ErrorStat atan2_stat = {0};
+    static const float radius[] = {1.0e-3f, 1.0f, 7.3f, 1.0e3f};
+    for (int r = 0; r < 4; r++)
+    {
+        for (int i = 0; i < samples / 4; i++)
+        {
+            double angle = -M_PI + 2.0 * M_PI * i / (samples / 4);
+            float y = (float)(radius[r] * sin(angle));
+            float x = (float)(radius[r] * cos(angle));
+            error_add(&atan2_stat, (float)angle, fast_atan2(y, x), atan2((double)y, (double)x));
+        }
+    }
+    error_print("fast_atan2", "full circle", &atan2_stat);
+
+    ErrorStat asin_stat = {0}, acos_stat = {0};
+    for (int i = 0; i <= samples; i++)
+    {
+        float x = -1.0f + 2.0f * i / samples;
+        error_add(&asin_stat, x, fast_asin(x), asin((double)x));
+        error_add(&acos_stat, x, fast_acos(x), acos((double)x));
+    }
+    error_print("fast_asin", "[-1, 1]", &asin_stat);
+    error_print("fast_acos", "[-1, 1]", &acos_stat);
+}
+
+/*
+ **************************************************************************
+ * speed
+ **************************************************************************
+ */
+static volatile float sink;
+
+#define BENCH(label, expr)                                       \
+    do                                                           \
+    {                                                            \
+        float acc = 0.0f;                                        \
+        double start = now_seconds();                            \
+        for (int i = 0; i < samples; i++)                        \
+        {                                                        \
+            float x = inputs[i];                                 \
+            (void)x;                                             \
+            acc += (expr);                                       \
+        }                                                        \
+        double elapsed = now_seconds() - start;                  \
+        sink = acc;                                              \
+        printf("%-28s %7.2f ns/call\n", label, elapsed * 1.0e9 / samples); \
+    } while (0)
+
+static void speed(int samples)
+{
+    float *inputs = malloc(sizeof(float) * samples);
+    float *inputs_b = malloc(sizeof(float) * samples);
+    srand(1);
+    for (int i = 0; i < samples; i++)
+    {
+        inputs[i] = ((float)rand() / RAND_MAX * 2.0f - 1.0f) * PI;
+        inputs_b[i] = (float)rand() / RAND_MAX * 2.0f - 1.0f;
+    }
+
+    float s, c;
+    BENCH("fast_sin_cos", (fast_sin_cos(x, &s, &c), s + c));
+    BENCH("sinf + cosf", sinf(x) + cosf(x));
+    BENCH("arm_sin_cos_f32 (degrees)", (arm_sin_cos_f32(x * (180.0f / PI), &s, &c), s + c));
+    BENCH("fast_atan2", fast_atan2(x, inputs_b[i]));
+    BENCH("atan2f", atan2f(x, inputs_b[i]));
+    BENCH("fast_asin", fast_asin(inputs_b[i]));
+    BENCH("asinf", asinf(inputs_b[i]));
+    BENCH("fast_acos", fast_acos(inputs_b[i]));
+    BENCH("acosf", acosf(inputs_b[i]));
+
+    free(inputs);
+    free(inputs_b);
+}
+
+int main(int argc, char **argv)
+{
+    int samples = (argc > 1) ? atoi(argv[1]) : BENCH_SAMPLES;
+    if (samples < 4)
+    {
+        fprintf(stderr, "usage: trig_bench [samples]\n");
+        return 1;
+    }
+
+    accuracy(samples);
+    printf("\n");
+    speed(samples);
+    return 0;
+}